@@ -66,6 +66,25 @@ bool NEAT::all_inputs_disconnected = true;
 
 double NEAT::step_size = 0.0;
 bool NEAT::use_cmaes = true;
+bool NEAT::common_random_numbers = false;
+bool NEAT::racing = false;
+unsigned int NEAT::racing_min_runs = 2;
+double NEAT::racing_width = 2.0;
+unsigned int NEAT::prefetch = 2;
+bool NEAT::shared_memory = false;
+bool NEAT::seeded_sampling = false;
+double NEAT::task_timeout = 0.0;
+bool NEAT::respawn = false;
+int NEAT::speculation = 0;
+int NEAT::async_batch = 0;
+unsigned NEAT::checkpoint_generations = 0;
+double NEAT::checkpoint_minutes = 0;
+int NEAT::restarts = 0;
+bool NEAT::separable = false;
+bool NEAT::use_lmmaes = false;
+unsigned NEAT::lmmaes_vectors = 0;
+bool NEAT::use_snes = false;
+bool NEAT::single_precision = false;
 
 int NEAT::getUnitCount(const char *string, const char *set)
 {
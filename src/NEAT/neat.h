@@ -84,6 +84,25 @@ namespace NEAT {
 
 	extern double step_size; // Step size parameter for cmaes algorithm
 	extern bool use_cmaes; // Boolean to define if the cmaes algorithm should be used or xnes
+	extern bool common_random_numbers; // Evaluate all the candidates of a generation on the same seeds
+	extern bool racing; // Stop evaluating the candidates that cannot reach the elite anymore
+	extern unsigned int racing_min_runs; // Number of runs every candidate gets before it can be dropped
+	extern double racing_width; // Half-width of the confidence interval of the race, in standard errors
+	extern unsigned int prefetch; // Number of tasks queued on each scheduler process
+	extern bool shared_memory; // Publish the weights of a generation once per node in shared memory
+	extern bool seeded_sampling; // Send the search distribution and candidate seeds instead of the weights
+	extern double task_timeout; // Seconds without result after which a scheduler is considered stuck, 0 for none
+	extern bool respawn; // Spawn a new scheduler in place of each stuck one
+	extern int speculation; // Copies of the last running tasks sent to idle schedulers, 0 to disable
+	extern int async_batch; // Candidates between two updates of the asynchronous CMA-ES, 0 to disable
+	extern unsigned checkpoint_generations; // Generations between two checkpoints, 0 to disable
+	extern double checkpoint_minutes; // Minutes between two checkpoints, 0 to disable
+	extern int restarts; // Restarts until the budget is spent: 0 none, 1 IPOP, 2 BIPOP
+	extern bool separable; // Diagonal covariance matrix for CMA-ES (sep-CMA-ES)
+	extern bool use_lmmaes; // Use LM-MA-ES instead of CMA-ES or xNES
+	extern unsigned lmmaes_vectors; // Direction vectors of LM-MA-ES, 0 for 4 + 3 ln N
+	extern bool use_snes; // Use SNES (diagonal xNES) instead of xNES
+	extern bool single_precision; // Covariance matrix of CMA-ES and xNES stored and updated in float
 
 	int getUnitCount(const char *string, const char *set);
 
@@ -0,0 +1,371 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pagmo/algorithm.hpp>
+#include "async_cmaes.hpp"
+#include "cma_update.hpp"
+#include <pagmo/detail/custom_comparisons.hpp>
+#include <pagmo/detail/eigen.hpp>
+#include <pagmo/detail/eigen_s11n.hpp>
+#include <pagmo/exceptions.hpp>
+#include <pagmo/io.hpp>
+#include <pagmo/population.hpp>
+#include <pagmo/s11n.hpp>
+#include <pagmo/types.hpp>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+
+#include "../problems/mpi_argos.hpp"
+
+namespace pagmo
+{
+
+async_cmaes::async_cmaes(unsigned gen, unsigned k, double sigma0, double ftol, double xtol, bool force_bounds,
+                         logger *log, unsigned seed)
+    : m_gen(gen), m_k(k), m_sigma0(sigma0), m_ftol(ftol), m_xtol(xtol), m_force_bounds(force_bounds), m_logger(log),
+      m_context(nullptr), m_checkpoint(nullptr), m_e(seed), m_seed(seed), m_verbosity(0u)
+{
+    sigma = m_sigma0;
+    mean = Eigen::VectorXd::Zero(1);
+    B = Eigen::MatrixXd::Identity(1, 1);
+    D = Eigen::MatrixXd::Identity(1, 1);
+    C = Eigen::MatrixXd::Identity(1, 1);
+    invsqrtC = Eigen::MatrixXd::Identity(1, 1);
+    pc = Eigen::VectorXd::Zero(1);
+    ps = Eigen::VectorXd::Zero(1);
+    counteval = 0u;
+    eigeneval = 0u;
+    n_updates = 0u;
+    m_gen_done = 0u;
+}
+
+/// Algorithm evolve method
+/**
+ * Evolves the population for a maximum number of generations (of \p lambda evaluations each), until one of the
+ * tolerances set on the population flatness (x_tol, f_tol) is met or the run budget is spent.
+ *
+ * @param pop population to be evolved
+ * @return evolved population, the last \p lambda evaluated candidates
+ * @throws std::invalid_argument if the problem is multi-objective or constrained
+ * @throws std::invalid_argument if the problem is unbounded or is not a pagmo::mpi_thread
+ * @throws std::invalid_argument if the population size is not at least 5
+ */
+population async_cmaes::evolve(population pop) const
+{
+    const auto &prob = pop.get_problem();
+    auto dim = prob.get_nx();
+    const auto bounds = prob.get_bounds();
+    const auto &lb = bounds.first;
+    const auto &ub = bounds.second;
+    auto lam = pop.size();
+    auto mu = lam / 2u;
+    auto count = 1u; // regulates the screen output
+
+    // PREAMBLE--------------------------------------------------
+    if (prob.get_nc() != 0u) {
+        pagmo_throw(std::invalid_argument, "Non linear constraints detected in " + prob.get_name() + " instance. "
+                                               + get_name() + " cannot deal with them");
+    }
+    if (prob.get_nf() != 1u) {
+        pagmo_throw(std::invalid_argument, "Multiple objectives detected in " + prob.get_name() + " instance. "
+                                               + get_name() + " cannot deal with them");
+    }
+    if (lam < 5u) {
+        pagmo_throw(std::invalid_argument, get_name() + " needs at least 5 individuals in the population, "
+                                               + std::to_string(lam) + " detected");
+    }
+    for (decltype(dim) j = 0u; j < dim; ++j) {
+        if (!std::isfinite(lb[j]) || !std::isfinite(ub[j])) {
+            pagmo_throw(std::invalid_argument,
+                        "Infinite bounds detected, " + this->get_name() + " cannot deal with them.");
+        }
+    }
+    const auto *evaluator = pop.get_problem().extract<mpi_thread>();
+    if (evaluator == nullptr) {
+        pagmo_throw(std::invalid_argument, get_name() + " evaluates its candidates asynchronously through a "
+                                               + "pagmo::mpi_thread problem, " + prob.get_name() + " detected");
+    }
+    if (m_gen == 0u) {
+        return pop;
+    }
+    // -----------------------------------------------------------
+
+    m_log.clear();
+    std::normal_distribution<double> normally_distributed_number(0., 1.);
+
+    // Recombination weights of the best half of the window and coefficients of a generational update, as in cmaes...
+    detail::cma_rates rates(mu, dim);
+    double N = rates.N;
+    // ...and of an update every k evaluations, lambda / k of which make a generation. The step-size damping stays the
+    // one of a generation.
+    auto k = m_k != 0u ? std::min<decltype(lam)>(m_k, lam) : std::max<decltype(lam)>(1u, lam / 4u);
+    double rate = static_cast<double>(k) / static_cast<double>(lam);
+    detail::cma_rates rates_k = rates;
+    rates_k.cm = rate;
+    rates_k.cc = 1. - std::pow(1. - rates.cc, rate);
+    rates_k.cs = 1. - std::pow(1. - rates.cs, rate);
+    rates_k.c1 = rates.c1 * rate;
+    rates_k.cmu = rates.cmu * rate;
+
+    // The algorithm memory is reset at every call, unless the algorithm was restored from a checkpoint
+    auto idx_b = pop.best_idx();
+    unsigned gen = m_gen_done;
+    m_gen_done = 0u;
+    if (gen == 0u) {
+        sigma = m_sigma0;
+        mean.resize(_(dim));
+        for (decltype(dim) i = 0u; i < dim; ++i) {
+            mean(_(i)) = pop.get_x()[idx_b][i];
+        }
+        B = Eigen::MatrixXd::Identity(_(dim), _(dim));
+        D = Eigen::MatrixXd::Identity(_(dim), _(dim));
+        for (decltype(dim) j = 0u; j < dim; ++j) {
+            D(_(j), _(j)) = std::max((ub[j] - lb[j]), 1e-6);
+        }
+        C = D * D;
+        invsqrtC = Eigen::MatrixXd::Identity(_(dim), _(dim));
+        for (decltype(dim) j = 0u; j < dim; ++j) {
+            invsqrtC(_(j), _(j)) = 1. / D(_(j), _(j));
+        }
+        pc = Eigen::VectorXd::Zero(_(dim));
+        ps = Eigen::VectorXd::Zero(_(dim));
+        counteval = 0u;
+        eigeneval = 0u;
+        n_updates = 0u;
+    }
+
+    if (m_verbosity > 0u) {
+        std::cout << "Asynchronous CMAES 4 PaGMO: " << std::endl;
+        std::cout << "mu: " << mu << " - lambda: " << lam << " - k: " << k << " - mueff: " << rates.mueff
+                  << " - N: " << N << std::endl;
+        std::cout << "cc: " << rates_k.cc << " - cs: " << rates_k.cs << " - c1: " << rates_k.c1
+                  << " - cmu: " << rates_k.cmu << " - sigma: " << sigma << " - damps: " << rates_k.damps
+                  << " - chiN: " << rates_k.chiN << std::endl;
+        if (m_logger && m_logger->is_genome() && gen == 0u) {
+            m_logger->save_hist_score(0, &pop);
+        }
+    }
+
+    // Some buffers
+    Eigen::VectorXd tmp = Eigen::VectorXd::Zero(_(dim));
+    Eigen::VectorXd y = Eigen::VectorXd::Zero(_(dim));
+    // Steps of the elite from the mean, one per column
+    Eigen::MatrixXd Y(_(dim), _(mu));
+    vector_double dumb(dim, 0.);
+    std::vector<vector_double> in_flight; // decision vectors of the submitted candidates, by ID
+    std::vector<population::size_type> best_idx(lam);
+    // The transformation of the normal vectors, computed once per eigendecomposition (D is diagonal)
+    Eigen::MatrixXd BD = B * D.diagonal().asDiagonal();
+    // The eigendecomposition of C runs on a helper thread during the next k evaluations, as in cmaes, and the new
+    // basis is swapped in at the next update
+    detail::cma_eigen<double> eigen;
+
+    // Draws a candidate from the current distribution and submits it
+    auto submit = [&]() {
+        for (decltype(dim) j = 0u; j < dim; ++j) {
+            tmp(_(j)) = normally_distributed_number(m_e);
+        }
+        y = mean + sigma * (BD * tmp);
+        for (decltype(dim) j = 0u; j < dim; ++j) {
+            dumb[j] = m_force_bounds ? std::min(std::max(y(_(j)), lb[j]), ub[j]) : y(_(j));
+        }
+        auto id = static_cast<std::size_t>(evaluator->async_submit(dumb));
+        if (id >= in_flight.size()) {
+            in_flight.resize(id + 1u);
+        }
+        in_flight[id] = dumb;
+    };
+
+    // The simulation seeds derive from the algorithm seed
+    if (prob.is_stochastic()) {
+        pop.get_problem().set_seed(std::uniform_int_distribution<unsigned>()(m_e));
+    }
+    if (m_context) {
+        m_context->begin_batch();
+    }
+    // Enough candidates to fill the task queues of all the processes, plus the ones of the next update
+    auto n_proc = evaluator->get_proc();
+    for (decltype(lam) i = 0u; i < static_cast<decltype(lam)>(evaluator->get_async_capacity()) + k; ++i) {
+        submit();
+    }
+
+    // ----------------------------------------------//
+    // HERE WE START THE JUICE OF THE ALGORITHM      //
+    // ----------------------------------------------//
+    auto gen_start = std::chrono::steady_clock::now();
+    decltype(lam) n_new = 0u;
+    bool stop = false;
+    double fitness;
+    int id;
+    while ((id = evaluator->async_collect(fitness)) >= 0) {
+        // 1 - The population holds the last lambda evaluated candidates: the new one replaces the oldest
+        pop.set_xf(counteval % lam, in_flight[static_cast<std::size_t>(id)], {fitness});
+        ++counteval;
+        ++n_new;
+
+        // 2 - Every lambda evaluations: logs and exit conditions
+        if (counteval % lam == 0u) {
+            ++gen;
+            idx_b = pop.best_idx();
+            auto idx_w = pop.worst_idx();
+            double dx = (sigma * (BD * tmp)).norm();
+            double df = std::abs(pop.get_f()[idx_b][0] - pop.get_f()[idx_w][0]);
+            if (m_verbosity > 0u && (gen % m_verbosity == 1u || m_verbosity == 1u)) {
+                // Fraction of the time the processes spent running the simulations of this generation
+                double busy = std::numeric_limits<double>::quiet_NaN();
+                if (m_context) {
+                    double seconds = 0.;
+                    for (const auto &record : m_context->get_run_table()) {
+                        seconds += record.seconds;
+                    }
+                    double elapsed
+                        = std::chrono::duration<double>(std::chrono::steady_clock::now() - gen_start).count();
+                    busy = seconds / (elapsed * n_proc);
+                }
+                if (count % 50u == 1u) {
+                    print("\n", std::setw(7), "Gen:", std::setw(15), "Fevals:", std::setw(15), "Best:", std::setw(15),
+                          "dx:", std::setw(15), "df:", std::setw(15), "sigma:", std::setw(15), "busy:", '\n');
+                }
+                print(std::setw(7), gen, std::setw(15), counteval, std::setw(15), pop.get_f()[idx_b][0],
+                      std::setw(15), dx, std::setw(15), df, std::setw(15), sigma, std::setw(15), busy, '\n');
+                ++count;
+                m_log.emplace_back(gen, counteval, pop.get_f()[idx_b][0], dx, df, sigma, busy);
+
+                if (m_logger && m_logger->is_genome()) {
+                    m_logger->save_hist_score(gen, &pop);
+                    std::vector<double> mean_val(mean.data(), mean.data() + mean.size());
+                    m_logger->save_to_file(gen, &mean_val[0], &pop);
+                }
+                if (m_logger && m_context) {
+                    m_logger->save_run_table(gen, *m_context);
+                }
+            }
+            if (m_context) {
+                m_context->begin_batch();
+            }
+            gen_start = std::chrono::steady_clock::now();
+
+            if (gen >= m_gen) {
+                if (m_verbosity) {
+                    std::cout << "Exit condition -- generations = " << m_gen << std::endl;
+                }
+                stop = true;
+            } else if (m_context && m_context->budget_exhausted()) {
+                if (m_verbosity > 0u) {
+                    std::cout << "Exit condition -- budget = " << m_context->get_run_budget() << std::endl;
+                }
+                stop = true;
+            } else if (dx < m_xtol) {
+                if (m_verbosity > 0u) {
+                    std::cout << "Exit condition -- xtol < " << m_xtol << std::endl;
+                }
+                stop = true;
+            } else if (df < m_ftol) {
+                if (m_verbosity > 0u) {
+                    std::cout << "Exit condition -- ftol < " << m_ftol << std::endl;
+                }
+                stop = true;
+            }
+            if (stop) {
+                // The candidates still in flight are not waited for, and their runs do not count against the budget
+                evaluator->async_cancel();
+                break;
+            }
+            // The window is complete: the candidates in flight are not saved, and the basis being decomposed is
+            // swapped in first
+            if (m_checkpoint && m_checkpoint->due(gen)) {
+                eigen.swap_in(B, D, invsqrtC, BD, m_verbosity > 0u);
+                m_gen_done = gen;
+                m_checkpoint->save(*this, gen, pop);
+                m_gen_done = 0u;
+            }
+        }
+        if (n_new < k) {
+            continue;
+        }
+        n_new = 0u;
+
+        // 3 - We extract the elite of the window
+        std::iota(best_idx.begin(), best_idx.end(), population::size_type(0));
+        std::sort(best_idx.begin(), best_idx.end(), [&pop](population::size_type idx1, population::size_type idx2) {
+            return detail::less_than_f(pop.get_f()[idx1][0], pop.get_f()[idx2][0]);
+        });
+        // 4 to 7 - The mean moves towards the recombination of the elite, by k / lambda of the way, and the evolution
+        // paths, the covariance matrix and sigma are updated with the step of a full generation
+        for (decltype(mu) i = 0u; i < mu; ++i) {
+            Y.col(_(i)) = Eigen::Map<const Eigen::VectorXd>(pop.get_x()[best_idx[i]].data(), _(dim)) - mean;
+        }
+        ++n_updates;
+        detail::cma_update(rates_k, static_cast<double>(n_updates), Y, sigma, mean, ps, pc, C, invsqrtC);
+        // The basis decomposed since the previous update samples the candidates submitted after this one
+        eigen.swap_in(B, D, invsqrtC, BD, m_verbosity > 0u);
+        // 8 - Perform eigen-decomposition of C, as often as cmaes does
+        if (static_cast<double>(counteval - eigeneval)
+            > (static_cast<double>(lam) / (rates.c1 + rates.cmu) / N / 10.)) {
+            eigeneval = counteval;
+            eigen.launch(C);
+        }
+        // 9 - Replace the finished candidates with new ones from the updated distribution
+        for (decltype(k) i = 0u; i < k; ++i) {
+            submit();
+        }
+    }
+    return pop;
+}
+
+/// Sets the seed
+/**
+ * @param seed the seed controlling the algorithm stochastic behaviour
+ */
+void async_cmaes::set_seed(unsigned seed)
+{
+    m_e.seed(seed);
+    m_seed = seed;
+}
+
+/// Extra info
+/**
+ * @return a string containing extra info on the algorithm
+ */
+std::string async_cmaes::get_extra_info() const
+{
+    std::ostringstream ss;
+    stream(ss, "\tGenerations: ", m_gen);
+    stream(ss, "\n\tk: ");
+    if (m_k == 0u)
+        stream(ss, "auto");
+    else
+        stream(ss, m_k);
+    stream(ss, "\n\tsigma0: ", m_sigma0);
+    stream(ss, "\n\tStopping xtol: ", m_xtol);
+    stream(ss, "\n\tStopping ftol: ", m_ftol);
+    stream(ss, "\n\tVerbosity: ", m_verbosity);
+    stream(ss, "\n\tForce bounds: ", m_force_bounds);
+    stream(ss, "\n\tSeed: ", m_seed);
+    return ss.str();
+}
+
+// Object serialization
+template <typename Archive>
+void async_cmaes::serialize(Archive &ar, unsigned)
+{
+    detail::archive(ar, m_gen, m_k, m_sigma0, m_ftol, m_xtol, m_force_bounds, sigma, mean, B, D, C, invsqrtC, pc, ps,
+                    counteval, eigeneval, n_updates, m_e, m_seed, m_verbosity, m_log, m_gen_done);
+}
+
+// The checkpoints of the evolution runs archive the algorithm in binary form (see checkpoint.hpp)
+template void async_cmaes::serialize(boost::archive::binary_oarchive &, unsigned);
+template void async_cmaes::serialize(boost::archive::binary_iarchive &, unsigned);
+
+} // namespace pagmo
@@ -0,0 +1,220 @@
+#ifndef PAGMO_ALGORITHMS_ASYNC_CMAES_HPP
+#define PAGMO_ALGORITHMS_ASYNC_CMAES_HPP
+
+#include <pagmo/config.hpp>
+
+#if defined(PAGMO_WITH_EIGEN3)
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <pagmo/algorithm.hpp>
+#include <pagmo/detail/eigen.hpp>
+#include <pagmo/detail/visibility.hpp>
+#include <pagmo/population.hpp>
+#include <pagmo/rng.hpp>
+#include <pagmo/s11n.hpp>
+
+#include "../checkpoint.hpp"
+#include "../eval_context.hpp"
+#include "../mylogger.hpp"
+
+namespace pagmo
+{
+/// Asynchronous steady-state CMA-ES
+/**
+ * A variant of pagmo::cmaes that never waits for a full generation. The candidates are evaluated through the
+ * asynchronous interface of pagmo::mpi_thread (see mpi_thread::async_submit()): whenever \p k of them are done,
+ * the mean, the evolution paths, the covariance matrix and the step-size are updated and \p k new candidates are
+ * sampled from the updated distribution and submitted, so that the processes freed by the finished candidates are
+ * fed at once whatever the spread of the simulation times.
+ *
+ * The population is a sliding window over the last \p lambda evaluated candidates: each update ranks the window and
+ * recombines its best half exactly as pagmo::cmaes recombines a generation. A candidate thus takes part in about
+ * <tt>lambda / k</tt> updates, so the learning rates of the mean and of the covariance matrix are scaled by
+ * <tt>k / lambda</tt>, and the cumulation rates of the evolution paths are set so that they decay over
+ * <tt>lambda / k</tt> updates as much as over one generation: with <tt>k = lambda</tt> the updates are the ones of
+ * pagmo::cmaes, except that the next generation is sampled before the current one is complete. Both algorithms share
+ * the update (see cma_update.hpp), and decompose the covariance matrix on a helper thread while the next candidates
+ * are evaluated.
+ *
+ * A generation is counted every \p lambda evaluations: the logs, the exit conditions, the checkpoints and the number
+ * of generations refer to those. The candidates still in flight when the algorithm stops are cancelled (see
+ * mpi_thread::async_cancel()), and their runs do not count against the budget; the ones in flight at a checkpoint are
+ * not saved, and are sampled anew on resume.
+ *
+ * \verbatim embed:rst:leading-asterisk
+ * .. note::
+ *
+ *    The problem must be a pagmo::mpi_thread. Its racing, common random numbers, speculation, shared generation
+ *    matrix and seeded sampling mode only apply to its batch evaluations, and are not used here.
+ * \endverbatim
+ */
+class PAGMO_DLL_PUBLIC async_cmaes
+{
+public:
+    /// Single data line for the algorithm's log.
+    /**
+     * A log data line is a tuple consisting of:
+     * - the generation number,
+     * - the number of function evaluations,
+     * - the best fitness in the window,
+     * - the norm of the last mutant vector,
+     * - the fitness flatness of the window, between its best and its worst individual,
+     * - the step-size,
+     * - the fraction of the time the processes spent running simulations during the generation: the runs count in
+     * the generation they end in, so that it may slightly exceed 1.
+     */
+    typedef std::tuple<unsigned, unsigned long long, double, double, double, double, double> log_line_type;
+
+    /// Log type.
+    typedef std::vector<log_line_type> log_type;
+
+    /// Constructor.
+    /**
+     * @param gen number of generations, i.e. of \p lambda evaluations.
+     * @param k number of finished candidates between two updates, 0 for a quarter of the population (at least 1).
+     * @param sigma0 initial step-size.
+     * @param ftol stopping criteria on the f tolerance (default is 1e-6).
+     * @param xtol stopping criteria on the x tolerance (default is 1e-6).
+     * @param force_bounds when true the box bounds are enforced.
+     * @param log logger of the scores and of the means.
+     * @param seed seed used by the internal random number generator (default is random).
+     */
+    async_cmaes(unsigned gen = 1, unsigned k = 0, double sigma0 = 0.5, double ftol = 1e-6, double xtol = 1e-6,
+                bool force_bounds = false, logger *log = nullptr, unsigned seed = pagmo::random_device::next());
+
+    // Algorithm evolve method
+    population evolve(population) const;
+
+    // Sets the seed
+    void set_seed(unsigned);
+
+    /// Gets the seed
+    unsigned get_seed() const
+    {
+        return m_seed;
+    }
+
+    /// Sets the algorithm verbosity
+    /**
+     * - 0: no verbosity
+     * - >0: will print and log one line each \p level generations, with the columns of pagmo::cmaes and the
+     * fraction of the time the processes were busy.
+     *
+     * @param level verbosity level
+     */
+    void set_verbosity(unsigned level)
+    {
+        m_verbosity = level;
+    }
+
+    /// Gets the verbosity level
+    unsigned get_verbosity() const
+    {
+        return m_verbosity;
+    }
+
+    /// Gets the generations
+    unsigned get_gen() const
+    {
+        return m_gen;
+    }
+
+    /// Sets the evaluation context
+    /**
+     * When a context is set, evolve() stops as soon as its run budget is spent, and the busy fraction of the
+     * processes is computed from its run table.
+     *
+     * @param context evaluation context shared with the problem, or nullptr.
+     */
+    void set_eval_context(eval_context *context)
+    {
+        m_context = context;
+    }
+
+    /// Sets the checkpoints
+    /**
+     * When set, the state of the algorithm and the population are saved at the end of every generation after which a
+     * checkpoint is due, and an algorithm restored from a checkpoint resumes after its last generation (see
+     * pagmo::checkpoint).
+     *
+     * @param cp checkpoints of the run, or nullptr.
+     */
+    void set_checkpoint(checkpoint *cp)
+    {
+        m_checkpoint = cp;
+    }
+
+    /// Algorithm name
+    std::string get_name() const
+    {
+        return "Asynchronous CMA-ES: steady-state Covariance Matrix Adaptation Evolutionary Strategy";
+    }
+
+    // Extra info
+    std::string get_extra_info() const;
+
+    /// Get log
+    const log_type &get_log() const
+    {
+        return m_log;
+    }
+
+private:
+    // Object serialization
+    friend class boost::serialization::access;
+    template <typename Archive>
+    void serialize(Archive &, unsigned);
+
+    template <typename I>
+    static Eigen::DenseIndex _(I n)
+    {
+        return static_cast<Eigen::DenseIndex>(n);
+    }
+
+    // Data members
+    unsigned m_gen;
+    unsigned m_k;
+    double m_sigma0;
+    double m_ftol;
+    double m_xtol;
+    bool m_force_bounds;
+    logger *m_logger;
+    eval_context *m_context;
+    checkpoint *m_checkpoint;
+
+    // Search distribution, adapted during each evolve call
+    mutable double sigma;
+    mutable Eigen::VectorXd mean;
+    mutable Eigen::MatrixXd B;
+    mutable Eigen::MatrixXd D;
+    mutable Eigen::MatrixXd C;
+    mutable Eigen::MatrixXd invsqrtC;
+    mutable Eigen::VectorXd pc;
+    mutable Eigen::VectorXd ps;
+    mutable unsigned long long counteval;
+    mutable unsigned long long eigeneval;
+    mutable unsigned long long n_updates;
+    // Generations done when checkpointed: evolve() resumes after them
+    mutable unsigned m_gen_done;
+
+    // "Common" data members
+    mutable detail::random_engine_type m_e;
+    unsigned m_seed;
+    unsigned m_verbosity;
+    mutable log_type m_log;
+};
+
+} // namespace pagmo
+
+PAGMO_S11N_ALGORITHM_EXPORT_KEY(pagmo::async_cmaes)
+
+#else // PAGMO_WITH_EIGEN3
+
+#error The async_cmaes.hpp header was included, but pagmo was not compiled with eigen3 support
+
+#endif // PAGMO_WITH_EIGEN3
+
+#endif
@@ -0,0 +1,250 @@
+#ifndef PAGMO_ALGORITHMS_CMA_UPDATE_HPP
+#define PAGMO_ALGORITHMS_CMA_UPDATE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <future>
+
+#include <pagmo/detail/eigen.hpp>
+#include <pagmo/io.hpp>
+
+#include "fixed_dim.hpp"
+
+// The update of the search distribution shared by pagmo::cmaes_t and pagmo::async_cmaes: the former applies it once
+// per generation, the latter every k evaluations with learning rates scaled down accordingly.
+
+namespace pagmo
+{
+namespace detail
+{
+
+/// Recombination weights and learning rates of a CMA-ES update
+struct cma_rates {
+    /// Default weights and rates of a generational update (Hansen, 2006)
+    /**
+     * @param mu number of recombined candidates.
+     * @param dim dimension of the problem.
+     */
+    cma_rates(unsigned long mu, unsigned long dim) : N(static_cast<double>(dim)), weights(static_cast<Eigen::Index>(mu))
+    {
+        for (Eigen::Index i = 0; i < weights.rows(); ++i) {
+            weights(i) = std::log(static_cast<double>(mu) + 0.5) - std::log(static_cast<double>(i) + 1.);
+        }
+        weights /= weights.sum();                     // weights for the weighted recombination
+        mueff = 1. / (weights.transpose() * weights); // variance-effectiveness of sum w_i x_i
+        cc = (4. + mueff / N) / (N + 4. + 2. * mueff / N);                    // t-const for cumulation for C
+        cs = (mueff + 2.) / (N + mueff + 5.);                                 // t-const for cumulation for sigma
+        c1 = 2. / ((N + 1.3) * (N + 1.3) + mueff);                            // learning rate for rank-one update of C
+        cmu = 2. * (mueff - 2. + 1. / mueff) / ((N + 2.) * (N + 2.) + mueff); // and for rank-mu update
+        set_damps();
+        chiN = std::sqrt(N) * (1. - 1. / (4. * N) + 1. / (21. * N * N)); // expectation of ||N(0,I)||
+    }
+
+    /// Sets the damping of the step-size from the current cs
+    void set_damps()
+    {
+        damps = 1. + 2. * std::max(0., std::sqrt((mueff - 1.) / (N + 1.)) - 1.) + cs;
+    }
+
+    double N;
+    Eigen::VectorXd weights;
+    double mueff;
+    /// Fraction of the way to the recombination of the elite the mean moves by
+    double cm = 1.;
+    double cc;
+    double cs;
+    double c1;
+    double cmu;
+    double damps;
+    double chiN;
+};
+
+namespace cma_kernel
+{
+
+// Steps 5 to 8 of the update, with the whitening of the step and the covariance update left to the caller
+template <typename Whiten, typename Adapt>
+void update(const cma_rates &r, double n_updates, Eigen::MatrixXd &Y, double &sigma, Eigen::VectorXd &mean,
+            Eigen::VectorXd &ps, Eigen::VectorXd &pc, Whiten &&whiten, Adapt &&adapt)
+{
+    auto dim = static_cast<unsigned>(mean.size());
+    with_fixed_dim(dim, [&](auto fixed) {
+        constexpr int Dim = decltype(fixed)::value;
+        Eigen::Map<fixed_vector<Dim>> xmean(mean.data(), mean.size()), xps(ps.data(), ps.size()),
+            xpc(pc.data(), pc.size());
+        Eigen::Map<fixed_columns<Dim>> xY(Y.data(), Y.rows(), Y.cols());
+        // 5 - Move the mean towards the recombination of the elite
+        fixed_vector<Dim> step = xY * r.weights / sigma;
+        xmean += (r.cm * sigma) * step;
+        // 6 - Update evolution paths, with the step of the full recombination
+        xps = (1. - r.cs) * xps + std::sqrt(r.cs * (2. - r.cs) * r.mueff) * whiten(fixed, step);
+        double hsig = (xps.squaredNorm() / r.N / (1. - std::pow((1. - r.cs), (2. * n_updates))))
+                      < (2. + 4. / (r.N + 1.));
+        xpc = (1. - r.cc) * xpc + hsig * std::sqrt(r.cc * (2. - r.cc) * r.mueff) * step;
+        // 7 - Adapt Covariance Matrix
+        adapt(fixed, xY, xpc, hsig);
+    });
+    // 8 - Adapt sigma
+    sigma *= std::exp(std::min(0.6, (r.cs / r.damps) * (ps.norm() / r.chiN - 1.)));
+}
+
+} // namespace cma_kernel
+
+/// Update of the mean, the evolution paths, the covariance matrix and the step-size
+/**
+ * C is blended in place and the rank-one and rank-mu updates are symmetric rank-k products Y diag(w) Y^T, which
+ * only write the lower triangle: the upper one is restored by cma_eigen::launch() before the eigendecomposition. The
+ * vectors are rounded to the precision of C. The kernel is compiled with the dimension fixed for the sizes of
+ * PAGMO_ES_FIXED_DIMS (see fixed_dim.hpp).
+ *
+ * @param r weights and learning rates of the update.
+ * @param n_updates number of updates so far, this one included, which corrects the hsig test for the short paths.
+ * @param Y steps of the mu elite from the mean, one per column, overwritten.
+ * @param sigma step-size, updated.
+ * @param mean mean, updated.
+ * @param ps evolution path of the step-size, updated.
+ * @param pc evolution path of the covariance matrix, updated.
+ * @param C covariance matrix, of which the lower triangle is updated.
+ * @param invsqrtC inverse square root of C, from its last eigendecomposition.
+ */
+template <typename Scalar>
+void cma_update(const cma_rates &r, double n_updates, Eigen::MatrixXd &Y, double &sigma, Eigen::VectorXd &mean,
+                Eigen::VectorXd &ps, Eigen::VectorXd &pc, Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic> &C,
+                const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic> &invsqrtC)
+{
+    auto n = mean.size();
+    double sigma_old = sigma;
+    cma_kernel::update(
+        r, n_updates, Y, sigma, mean, ps, pc,
+        [&](auto fixed, const auto &step) {
+            constexpr int Dim = decltype(fixed)::value;
+            Eigen::Map<const fixed_matrix<Dim, Scalar>> xinvsqrtC(invsqrtC.data(), n, n);
+            return fixed_vector<Dim>((xinvsqrtC * step.template cast<Scalar>()).template cast<double>());
+        },
+        [&](auto fixed, auto &xY, const auto &xpc, double hsig) {
+            constexpr int Dim = decltype(fixed)::value;
+            Eigen::Map<fixed_matrix<Dim, Scalar>> xC(C.data(), n, n);
+            xC *= static_cast<Scalar>(1. - r.c1 - r.cmu + r.c1 * (1. - hsig) * r.cc * (2. - r.cc));
+            xC.template selfadjointView<Eigen::Lower>().rankUpdate(xpc.template cast<Scalar>(),
+                                                                   static_cast<Scalar>(r.c1));
+            xY *= (r.weights.cwiseSqrt() / sigma_old).asDiagonal();
+            xC.template selfadjointView<Eigen::Lower>().rankUpdate(xY.template cast<Scalar>(),
+                                                                   static_cast<Scalar>(r.cmu));
+        });
+}
+
+/// The same update, for the diagonal covariance matrix of the separable variant
+/**
+ * Only the diagonal of the update is computed, in O(N).
+ *
+ * @param diagC diagonal of the covariance matrix, updated.
+ * @param diagD standard deviations along the axes, the square root of \p diagC before the update.
+ */
+inline void cma_update_diagonal(const cma_rates &r, double n_updates, Eigen::MatrixXd &Y, double &sigma,
+                                Eigen::VectorXd &mean, Eigen::VectorXd &ps, Eigen::VectorXd &pc,
+                                Eigen::VectorXd &diagC, const Eigen::VectorXd &diagD)
+{
+    double sigma_old = sigma;
+    cma_kernel::update(
+        r, n_updates, Y, sigma, mean, ps, pc,
+        [&](auto fixed, const auto &step) {
+            constexpr int Dim = decltype(fixed)::value;
+            return fixed_vector<Dim>(step.cwiseQuotient(diagD));
+        },
+        [&](auto, auto &xY, const auto &xpc, double hsig) {
+            diagC = (1. - r.c1 - r.cmu) * diagC + r.cmu * (xY.cwiseAbs2() * r.weights) / (sigma_old * sigma_old)
+                    + r.c1 * (xpc.cwiseAbs2() + (1. - hsig) * r.cc * (2. - r.cc) * diagC);
+        });
+}
+
+/// Eigendecomposition of the covariance matrix, as run by the helper thread, in the precision of the matrices
+template <typename Scalar>
+struct eigen_result {
+    bool success = false;
+    // Eigenvectors, and standard deviations along them
+    Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic> B;
+    Eigen::Matrix<Scalar, Eigen::Dynamic, 1> d;
+    // Inverse square root of C, and transformation of the normal vectors
+    Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic> invsqrtC;
+    Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic> BD;
+    // Time the decomposition took
+    double seconds = 0.;
+};
+
+template <typename Matrix>
+eigen_result<typename Matrix::Scalar> decompose(const Matrix &C)
+{
+    using Scalar = typename Matrix::Scalar;
+    auto start = std::chrono::steady_clock::now();
+    eigen_result<Scalar> res;
+    Eigen::SelfAdjointEigenSolver<Matrix> es(C);
+    if (es.info() == Eigen::Success) {
+        res.success = true;
+        res.B = es.eigenvectors();
+        res.d = es.eigenvalues().cwiseMax(Scalar(1e-20)).cwiseSqrt(); // d contains standard deviations now
+        res.invsqrtC = res.B * res.d.cwiseInverse().asDiagonal() * res.B.transpose();
+        res.BD = res.B * res.d.asDiagonal();
+    }
+    res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return res;
+}
+
+/// Eigendecomposition of the covariance matrix on a helper thread
+/**
+ * The decomposition runs while the next candidates are sampled and evaluated with the last basis, as the lazy update
+ * schedule of CMA-ES allows, and swap_in() waits for it and swaps the new basis in at once.
+ */
+template <typename Scalar>
+class cma_eigen
+{
+public:
+    using matrix_type = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>;
+
+    /// Starts decomposing a copy of \p C, whose upper triangle is first restored from the lower one
+    void launch(matrix_type &C)
+    {
+        C.template triangularView<Eigen::StrictlyUpper>() = C.transpose(); // enforce symmetry
+        m_pending = std::async(std::launch::async, decompose<matrix_type>, C);
+    }
+
+    /// Whether a decomposition was launched and not swapped in yet
+    bool pending() const
+    {
+        return m_pending.valid();
+    }
+
+    /// Waits for the launched decomposition, if any, and swaps the new basis in
+    /**
+     * If the decomposition failed, the previous basis is kept.
+     *
+     * @param verbose whether to print the time the decomposition took and how much of it was hidden.
+     */
+    void swap_in(matrix_type &B, matrix_type &D, matrix_type &invsqrtC, matrix_type &BD, bool verbose)
+    {
+        if (!m_pending.valid()) {
+            return;
+        }
+        auto start = std::chrono::steady_clock::now();
+        auto res = m_pending.get();
+        double waited = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (res.success) {
+            B = std::move(res.B);
+            D = res.d.asDiagonal();
+            invsqrtC = std::move(res.invsqrtC);
+            BD = std::move(res.BD);
+        }
+        if (verbose) {
+            print("Eigendecomposition: ", res.seconds, " s, hidden behind the evaluation: ",
+                  std::max(0., res.seconds - waited), " s\n");
+        }
+    }
+
+private:
+    std::future<eigen_result<Scalar>> m_pending;
+};
+
+} // namespace detail
+} // namespace pagmo
+
+#endif
@@ -38,7 +38,9 @@ see https://www.gnu.org/licenses/. */
 #include <vector>
 
 #include <pagmo/algorithm.hpp>
+#include "cma_update.hpp"
 #include "cmaes.hpp"
+#include "fixed_dim.hpp"
 #include <pagmo/detail/custom_comparisons.hpp>
 #include <pagmo/detail/eigen.hpp>
 #include <pagmo/detail/eigen_s11n.hpp>
@@ -48,6 +50,9 @@ see https://www.gnu.org/licenses/. */
 #include <pagmo/s11n.hpp>
 #include <pagmo/types.hpp>
 
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+
 // NOTE: apparently this must be included *after*
 // the other serialization headers.
 #include <boost/serialization/optional.hpp>
@@ -55,11 +60,12 @@ see https://www.gnu.org/licenses/. */
 namespace pagmo
 {
 
-cmaes::cmaes(unsigned gen, double cc, double cs, double c1, double cmu, double sigma0, double ftol,
-             double xtol, bool memory, bool force_bounds, logger* log, unsigned seed)
+template <typename Scalar>
+cmaes_t<Scalar>::cmaes_t(unsigned gen, double cc, double cs, double c1, double cmu, double sigma0, double ftol,
+                         double xtol, bool memory, bool force_bounds, logger *log, unsigned seed)
     : m_gen(gen), m_cc(cc), m_cs(cs), m_c1(c1), m_cmu(cmu), m_sigma0(sigma0), m_ftol(ftol),
-      m_xtol(xtol), m_memory(memory), m_force_bounds(force_bounds), m_logger(log), m_e(seed),
-      m_seed(seed), m_verbosity(0u) {
+      m_xtol(xtol), m_memory(memory), m_force_bounds(force_bounds), m_separable(false), m_logger(log),
+      m_context(nullptr), m_checkpoint(nullptr), m_e(seed), m_seed(seed), m_verbosity(0u) {
     if (((cc < 0.) || (cc > 1.)) && !(cc == -1)) {
         pagmo_throw(std::invalid_argument,
                     "cc must be in [0,1] or -1 if its value has to be initialized automatically, a value of "
@@ -85,15 +91,17 @@ cmaes::cmaes(unsigned gen, double cc, double cs, double c1, double cmu, double s
     sigma = m_sigma0;
     mean = Eigen::VectorXd::Zero(1);
     variation = Eigen::VectorXd::Zero(1);
-    newpop = std::vector<Eigen::VectorXd>{};
-    B = Eigen::MatrixXd::Identity(1, 1);
-    D = Eigen::MatrixXd::Identity(1, 1);
-    C = Eigen::MatrixXd::Identity(1, 1);
-    invsqrtC = Eigen::MatrixXd::Identity(1, 1);
+    newpop = vector_double{};
+    B = matrix_type::Identity(1, 1);
+    D = matrix_type::Identity(1, 1);
+    C = matrix_type::Identity(1, 1);
+    invsqrtC = matrix_type::Identity(1, 1);
+    diagC = Eigen::VectorXd::Ones(1);
     pc = Eigen::VectorXd::Zero(1);
     ps = Eigen::VectorXd::Zero(1);
     counteval = 0u;
     eigeneval = 0u;
+    m_gen_done = 0u;
 }
 
 /// Algorithm evolve method
@@ -108,7 +116,8 @@ cmaes::cmaes(unsigned gen, double cc, double cs, double c1, double cmu, double s
  * @throws std::invalid_argument if the problem is unbounded
  * @throws std::invalid_argument if the population size is not at least 5
  */
-population cmaes::evolve(population pop) const
+template <typename Scalar>
+population cmaes_t<Scalar>::evolve(population pop) const
 {
     // We store some useful variables
     const auto &prob = pop.get_problem(); // This is a const reference, so using set_seed for example will not be
@@ -160,85 +169,100 @@ population cmaes::evolve(population pop) const
 
     // Initializing the random number generators
     std::uniform_real_distribution<double> randomly_distributed_number(0., 1.); // to generate a number in [0, 1)
-    std::normal_distribution<double> normally_distributed_number(
-        0., 1.); // to generate a normally distributed number        // Setting coefficients for Selection
-    Eigen::VectorXd weights(_(mu));
-    for (decltype(weights.rows()) i = 0; i < weights.rows(); ++i) {
-        weights(i) = std::log(static_cast<double>(mu) + 0.5) - std::log(static_cast<double>(i) + 1.);
+    std::normal_distribution<double> normally_distributed_number(0., 1.); // to generate a normally distributed number
+    // Setting the recombination weights, and the coefficients for Adaptation automatically or to user defined data
+    detail::cma_rates rates(mu, dim);
+    double N = rates.N;
+    if (m_cc != -1) {
+        rates.cc = m_cc;
     }
-    weights /= weights.sum();                            // weights for the weighted recombination
-    double mueff = 1. / (weights.transpose() * weights); // variance-effectiveness of sum w_i x_i
-
-    // Setting coefficients for Adaptation automatically or to user defined data
-    double cc(m_cc), cs(m_cs), c1(m_c1), cmu(m_cmu);
-    double N = static_cast<double>(dim);
-    if (cc == -1) {
-        cc = (4. + mueff / N) / (N + 4. + 2. * mueff / N); // t-const for cumulation for C
+    if (m_cs != -1) {
+        rates.cs = m_cs;
+        rates.set_damps();
     }
-    if (cs == -1) {
-        cs = (mueff + 2.) / (N + mueff + 5.); // t-const for cumulation for sigma control
+    if (m_c1 != -1) {
+        rates.c1 = m_c1;
     }
-    if (c1 == -1) {
-        c1 = 2. / ((N + 1.3) * (N + 1.3) + mueff); // learning rate for rank-one update of C
+    if (m_cmu != -1) {
+        rates.cmu = m_cmu;
     }
-    if (cmu == -1) {
-        cmu = 2. * (mueff - 2. + 1. / mueff) / ((N + 2.) * (N + 2.) + mueff); // and for rank-mu update
+    if (m_separable) {
+        // A diagonal matrix has N parameters to learn instead of N^2 / 2, so it can learn faster
+        // (Ros and Hansen, 2008)
+        if (m_c1 == -1) {
+            rates.c1 *= (N + 2.) / 3.;
+        }
+        if (m_cmu == -1) {
+            rates.cmu = std::min(1. - rates.c1, rates.cmu * (N + 2.) / 3.);
+        }
     }
 
-    double damps
-        = 1. + 2. * std::max(0., std::sqrt((mueff - 1.) / (N + 1.)) - 1.) + cs; // damping coefficient for sigma
-    double chiN
-        = std::sqrt(N) * (1. - 1. / (4. * N) + 1. / (21. * N * N)); // expectation of ||N(0,I)|| == norm(randn(N,1))
-
     // Some buffers
-    Eigen::VectorXd meanold = Eigen::VectorXd::Zero(_(dim));
-    Eigen::MatrixXd Dinv = Eigen::MatrixXd::Identity(_(dim), _(dim));
-    Eigen::MatrixXd Cold = Eigen::MatrixXd::Identity(_(dim), _(dim));
     Eigen::VectorXd tmp = Eigen::VectorXd::Zero(_(dim));
-    std::vector<Eigen::VectorXd> elite(mu, tmp);
+    Eigen::MatrixXd Z(_(dim), _(lam));
+    // Steps of the elite from the old mean, one per column
+    Eigen::MatrixXd Y(_(dim), _(mu));
     vector_double dumb(dim, 0.);
 
     // If the algorithm is called for the first time on this problem dimension / pop size or if m_memory is false we
-    // erase the memory of past calls
-    if ((newpop.size() != lam) || (static_cast<unsigned>(newpop[0].rows()) != dim) || (m_memory == false)) {
+    // erase the memory of past calls, unless the algorithm was restored from a checkpoint
+    if ((newpop.size() != lam * dim) || (mean.size() != _(dim))
+        || ((m_separable ? diagC.rows() : C.rows()) != _(dim)) || (m_memory == false && m_gen_done == 0u)) {
         sigma = m_sigma0;
         mean.resize(_(dim));
         auto idx_b = pop.best_idx();
         for (decltype(dim) i = 0u; i < dim; ++i) {
             mean(_(i)) = pop.get_x()[idx_b][i];
         }
-        newpop = std::vector<Eigen::VectorXd>(lam, tmp);
+        newpop = vector_double(lam * dim, 0.);
         variation.resize(_(dim));
 
-        // We define the starting B,D,C
-        B = Eigen::MatrixXd::Identity(_(dim), _(dim)); // B defines the coordinate system
-        D = Eigen::MatrixXd::Identity(_(dim), _(dim));
-        // diagonal D defines the scaling. By default this is the width of the box bounds.
-        // If this is too small... then 1e-6 is used
-        for (decltype(dim) j = 0u; j < dim; ++j) {
-            D(_(j), _(j)) = std::max((ub[j] - lb[j]), 1e-6);
-        }
-        C = Eigen::MatrixXd::Identity(_(dim), _(dim)); // covariance matrix C
-        C = D * D;
-        invsqrtC = Eigen::MatrixXd::Identity(_(dim), _(dim)); // inverse of sqrt(C)
-        for (decltype(dim) j = 0; j < dim; ++j) {
-            invsqrtC(_(j), _(j)) = 1. / D(_(j), _(j));
+        if (m_separable) {
+            // The covariance matrix is diagonal and its diagonal is all that is kept
+            diagC.resize(_(dim));
+            for (decltype(dim) j = 0u; j < dim; ++j) {
+                diagC(_(j)) = std::max((ub[j] - lb[j]), 1e-6) * std::max((ub[j] - lb[j]), 1e-6);
+            }
+        } else {
+            // We define the starting B,D,C
+            B = matrix_type::Identity(_(dim), _(dim)); // B defines the coordinate system
+            D = matrix_type::Identity(_(dim), _(dim));
+            // diagonal D defines the scaling. By default this is the width of the box bounds.
+            // If this is too small... then 1e-6 is used
+            for (decltype(dim) j = 0u; j < dim; ++j) {
+                D(_(j), _(j)) = static_cast<Scalar>(std::max((ub[j] - lb[j]), 1e-6));
+            }
+            C = matrix_type::Identity(_(dim), _(dim)); // covariance matrix C
+            C = D * D;
+            invsqrtC = matrix_type::Identity(_(dim), _(dim)); // inverse of sqrt(C)
+            for (decltype(dim) j = 0; j < dim; ++j) {
+                invsqrtC(_(j), _(j)) = Scalar(1) / D(_(j), _(j));
+            }
         }
         pc = Eigen::VectorXd::Zero(_(dim));
         ps = Eigen::VectorXd::Zero(_(dim));
         counteval = 0u;
         eigeneval = 0u;
+        m_gen_done = 0u;
     }
+    auto first_gen = m_gen_done + 1u;
+    m_gen_done = 0u;
+    // Standard deviations along the axes, for the separable variant
+    Eigen::VectorXd diagD = m_separable ? diagC.cwiseSqrt().eval() : Eigen::VectorXd();
+    // The transformation of the normal vectors, computed once per eigendecomposition (D is diagonal)
+    matrix_type BD = m_separable ? matrix_type() : (B * D.diagonal().asDiagonal()).eval();
+    // The candidates, one per column, viewed in place in the buffer that the bfe evaluates
+    Eigen::Map<Eigen::MatrixXd> X(newpop.data(), _(dim), _(lam));
 
     if (m_verbosity > 0u) {
-        std::cout << "CMAES 4 PaGMO: " << std::endl;
-        std::cout << "mu: " << mu << " - lambda: " << lam << " - mueff: " << mueff << " - N: " << N
+        std::cout << (m_separable ? "sep-CMAES 4 PaGMO: " : "CMAES 4 PaGMO: ") << std::endl;
+        std::cout << "mu: " << mu << " - lambda: " << lam << " - mueff: " << rates.mueff << " - N: " << N
                   << std::endl;
-        std::cout << "cc: " << cc << " - cs: " << cs << " - c1: " << c1 << " - cmu: " << cmu
-                  << " - sigma: " << sigma << " - damps: " << damps << " - chiN: " << chiN
+        std::cout << "cc: " << rates.cc << " - cs: " << rates.cs << " - c1: " << rates.c1 << " - cmu: " << rates.cmu
+                  << " - sigma: " << sigma << " - damps: " << rates.damps << " - chiN: " << rates.chiN
                   << std::endl;
 
-        if (m_logger->is_genome()) {
+        if (m_logger && m_logger->is_genome() && first_gen == 1u) {
             m_logger->save_hist_score(0, &pop);
         }
     }
@@ -246,22 +270,83 @@ population cmaes::evolve(population pop) const
     // ----------------------------------------------//
     // HERE WE START THE JUICE OF THE ALGORITHM      //
     // ----------------------------------------------//
-    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(_(dim));
-    for (decltype(m_gen) gen = 1u; gen <= m_gen; ++gen) {
+    // The eigendecomposition of C runs on a helper thread while the next generation is sampled, evaluated and
+    // recombined with the last basis, as the lazy update schedule allows: that generation whitens its steps with the
+    // invsqrtC that goes with the BD it was sampled with. The new basis is then swapped in at once, before the
+    // generation after is sampled.
+    detail::cma_eigen<Scalar> eigen;
+    // A decomposition launched by the last generation of a previous call (or of the checkpointed run) is still to be
+    // swapped in: it is run again on the same C, which gives the same basis, so that the trajectory does not depend
+    // on where the generations are split between calls
+    if (!m_separable && counteval > 0u && eigeneval == counteval) {
+        eigen.launch(C);
+    }
+    for (decltype(m_gen) gen = first_gen; gen <= m_gen; ++gen) {
+        // 0 - Exit condition on the run budget
+        if (m_context && m_context->budget_exhausted()) {
+            if (m_verbosity > 0u) {
+                std::cout << "Exit condition -- budget = " << m_context->get_run_budget() << std::endl;
+            }
+            return pop;
+        }
         // 1 - We generate and evaluate lam new individuals
-        for (decltype(lam) i = 0u; i < lam; ++i) {
-            // 1a - we create a randomly normal distributed vector
-            for (decltype(dim) j = 0u; j < dim; ++j) {
-                tmp(_(j)) = normally_distributed_number(m_e);
+        if (m_context && m_context->get_seeded_sampling()) {
+            // In the seeded sampling mode the individuals are drawn by sample_candidate() from one seed each,
+            // and the distribution and seeds are left to the evaluator, which can send them instead of the
+            // individuals. The bounds are fixed by the kernel, so step 2 leaves them untouched.
+            auto &batch = m_context->get_sampling_batch();
+            batch.state.mean = mean;
+            batch.state.diagonal = m_separable;
+            if (m_separable) {
+                batch.state.scale = sigma * diagD;
+            } else {
+                batch.state.transform = sigma * BD.template cast<double>();
             }
-            // 1b - and store its transformed value in the newpop
-            newpop[i] = mean + (sigma * B * D * tmp);
+            batch.state.force_bounds = m_force_bounds;
+            batch.state.lb = Eigen::Map<const Eigen::VectorXd>(lb.data(), _(dim));
+            batch.state.ub = Eigen::Map<const Eigen::VectorXd>(ub.data(), _(dim));
+            batch.seeds.resize(lam);
+            Eigen::VectorXd x;
+            for (decltype(lam) i = 0u; i < lam; ++i) {
+                batch.seeds[i] = std::uniform_int_distribution<unsigned>()(m_e);
+                sample_candidate(batch.state, batch.seeds[i], tmp, x);
+                Z.col(_(i)) = tmp;
+                X.col(_(i)) = x;
+            }
+        } else {
+            // 1a - we create lam randomly normal distributed vectors
+            for (decltype(lam) i = 0u; i < lam; ++i) {
+                for (decltype(dim) j = 0u; j < dim; ++j) {
+                    Z(_(j), _(i)) = normally_distributed_number(m_e);
+                }
+            }
+            // 1b - and store their transformed values in the newpop, with a single matrix product (in the precision
+            // of BD, the normal vectors being rounded to it)
+            detail::with_fixed_dim(dim, [&](auto fixed) {
+                constexpr int Dim = decltype(fixed)::value;
+                Eigen::Map<detail::fixed_columns<Dim>> xX(X.data(), _(dim), _(lam));
+                Eigen::Map<const detail::fixed_columns<Dim>> xZ(Z.data(), _(dim), _(lam));
+                if (m_separable) {
+                    xX.noalias() = diagD.asDiagonal() * xZ * sigma;
+                } else {
+                    Eigen::Map<const detail::fixed_matrix<Dim, Scalar>> xBD(BD.data(), _(dim), _(dim));
+                    xX.noalias() = sigma * (xBD * xZ.template cast<Scalar>()).template cast<double>();
+                }
+                xX.colwise() += Eigen::Map<const detail::fixed_vector<Dim>>(mean.data(), _(dim));
+            });
+        }
+        // The last mutation, which the exit condition and the logs look at
+        if (m_separable) {
+            variation = sigma * diagD.cwiseProduct(Z.col(_(lam - 1u)));
+        } else {
+            variation.noalias()
+                = sigma * (BD * Z.col(_(lam - 1u)).template cast<Scalar>()).template cast<double>();
         }
 
         // 1bis - Check the exit conditions and logs
         // Exit condition on xtol
         {
-            if ((sigma * B * D * tmp).norm() < m_xtol) {
+            if (variation.norm() < m_xtol) {
                 if (m_verbosity > 0u) {
                     std::cout << "Exit condition -- xtol < " << m_xtol << std::endl;
                 }
@@ -284,7 +369,7 @@ population cmaes::evolve(population pop) const
             // Every m_verbosity generations print a log line
             if (gen % m_verbosity == 1u || m_verbosity == 1u) {
                 // The population flatness in chromosome
-                auto dx = (sigma * B * D * tmp).norm();
+                auto dx = variation.norm();
                 // The population flatness in fitness
                 auto idx_b = pop.best_idx();
                 auto idx_w = pop.worst_idx();
@@ -309,6 +394,9 @@ population cmaes::evolve(population pop) const
                     }
                     m_logger->save_to_file(gen, &mean_val[0], &pop);
                 }
+                if (m_context) {
+                    m_logger->save_run_table(gen, *m_context);
+                }
             }
         }
         // 2 - We fix the bounds.
@@ -317,10 +405,10 @@ population cmaes::evolve(population pop) const
         if (m_force_bounds) {
             for (decltype(lam) i = 0u; i < lam; ++i) {
                 for (decltype(dim) j = 0u; j < dim; ++j) {
-                    if (newpop[i](_(j)) < lb[j]) {
-                        newpop[i](_(j)) = lb[j];
-                    } else if (newpop[i](_(j)) > ub[j]) {
-                        newpop[i](_(j)) = ub[j];
+                    if (X(_(j), _(i)) < lb[j]) {
+                        X(_(j), _(i)) = lb[j];
+                    } else if (X(_(j), _(i)) > ub[j]) {
+                        X(_(j), _(i)) = ub[j];
                     }
                 }
             }
@@ -332,32 +420,18 @@ population cmaes::evolve(population pop) const
             pop.get_problem().set_seed(std::uniform_int_distribution<unsigned>()(m_e));
         }
         // Reinsertion
-        for (decltype(lam) i = 0u; i < lam; ++i) {
-            for (decltype(dim) j = 0u; j < dim; ++j) {
-                dumb[j] = newpop[i](_(j));
-            }
-            if (!m_bfe) {
-                // bfe not available
-                pop.set_x(i, dumb);
-            }
-        }
-        if (m_bfe) {
-            // bfe is available:
-            vector_double decision_vectors(lam * dim);
-            vector_double::size_type pos = 0u;
+        if (!m_bfe) {
+            // bfe not available
             for (decltype(lam) i = 0u; i < lam; ++i) {
-                for (decltype(dim) j = 0u; j < dim; ++j) {
-                    decision_vectors[pos] = newpop[i](_(j));
-                    ++pos;
-                }
+                std::copy(newpop.begin() + i * dim, newpop.begin() + (i + 1u) * dim, dumb.begin());
+                pop.set_x(i, dumb);
             }
-            // run bfe.
-            auto fitnesses = (*m_bfe)(prob, decision_vectors);
+        } else {
+            // bfe is available: newpop already holds the candidates one after the other.
+            auto fitnesses = (*m_bfe)(prob, newpop);
 
             for (decltype(lam) i = 0u; i < lam; ++i) {
-                for (decltype(dim) j = 0u; j < dim; ++j) {
-                    dumb[j] = newpop[i](_(j));
-                }
+                std::copy(newpop.begin() + i * dim, newpop.begin() + (i + 1u) * dim, dumb.begin());
                 pop.set_xf(i, dumb, {fitnesses[i]});
             }
         }
@@ -369,51 +443,33 @@ population cmaes::evolve(population pop) const
             return detail::less_than_f(pop.get_f()[idx1][0], pop.get_f()[idx2][0]);
         });
         best_idx.resize(mu); // not needed?
+        // The candidates of newpop are those of the population, bounds included
         for (decltype(mu) i = 0u; i < mu; ++i) {
-            for (decltype(dim) j = 0u; j < dim; ++j) {
-                elite[i](_(j)) = pop.get_x()[best_idx[i]][j];
-            }
-        }
-        // 5 - Compute the new mean of the elite storing the old one
-        meanold = mean;
-        mean = elite[0] * weights(0);
-        for (decltype(mu) i = 1u; i < mu; ++i) {
-            mean += elite[i] * weights(_(i));
+            Y.col(_(i)) = X.col(_(best_idx[i])) - mean;
         }
-        // 6 - Update evolution paths
-        ps = (1. - cs) * ps + std::sqrt(cs * (2. - cs) * mueff) * invsqrtC * (mean - meanold) / sigma;
-        double hsig = 0.;
-        hsig = (ps.squaredNorm() / N
-                / (1. - std::pow((1. - cs), (2. * static_cast<double>(counteval) / static_cast<double>(lam)))))
-               < (2. + 4. / (N + 1.));
-        pc = (1. - cc) * pc + hsig * std::sqrt(cc * (2. - cc) * mueff) * (mean - meanold) / sigma;
-        // 7 - Adapt Covariance Matrix
-        Cold = C;
-        C = (elite[0] - meanold) * (elite[0] - meanold).transpose() * weights(0);
-        for (decltype(mu) i = 1u; i < mu; ++i) {
-            C += (elite[i] - meanold) * (elite[i] - meanold).transpose() * weights(_(i));
+        // 5 to 8 - Update the mean, the evolution paths, the covariance matrix and sigma
+        auto n_updates = static_cast<double>(counteval) / static_cast<double>(lam);
+        if (m_separable) {
+            detail::cma_update_diagonal(rates, n_updates, Y, sigma, mean, ps, pc, diagC, diagD);
+        } else {
+            detail::cma_update(rates, n_updates, Y, sigma, mean, ps, pc, C, invsqrtC);
         }
-        C /= sigma * sigma;
-        C = (1. - c1 - cmu) * Cold + cmu * C + c1 * ((pc * pc.transpose()) + (1. - hsig) * cc * (2. - cc) * Cold);
-        // 8 - Adapt sigma
-        sigma *= std::exp(std::min(0.6, (cs / damps) * (ps.norm() / chiN - 1.)));
-        // 9 - Perform eigen-decomposition of C
-        if (static_cast<double>(counteval - eigeneval)
-            > (static_cast<double>(lam) / (c1 + cmu) / N / 10.)) { // achieve O(N^2)
+        // The basis decomposed during this generation is used from the next one
+        eigen.swap_in(B, D, invsqrtC, BD, m_verbosity > 0u);
+        // 9 - Perform eigen-decomposition of C (the axes of a diagonal C are the coordinate axes)
+        if (m_separable) {
+            diagD = diagC.cwiseMax(1e-20).cwiseSqrt();
+        } else if (static_cast<double>(counteval - eigeneval)
+                   > (static_cast<double>(lam) / (rates.c1 + rates.cmu) / N / 10.)) { // achieve O(N^2)
             eigeneval = counteval;
-            C = (C + C.transpose()) / 2.; // enforce symmetry
-            es.compute(C);                // eigen decomposition
-            if (es.info() == Eigen::Success) {
-                B = es.eigenvectors();
-                D = es.eigenvalues().asDiagonal();
-                for (decltype(dim) j = 0u; j < dim; ++j) {
-                    D(_(j), _(j)) = std::sqrt(std::max(1e-20, D(_(j), _(j)))); // D contains standard deviations now
-                }
-                for (decltype(dim) j = 0u; j < dim; ++j) {
-                    Dinv(_(j), _(j)) = 1. / D(_(j), _(j));
-                }
-                invsqrtC = B * Dinv * B.transpose();
-            } // if eigendecomposition fails just skip it and keep previous successful one.
+            // eigen decomposition, of a copy of C, on the helper thread
+            eigen.launch(C);
+        }
+        // 10 - Save a checkpoint, from which evolve() resumes after this generation
+        if (m_checkpoint && m_checkpoint->due(gen)) {
+            m_gen_done = gen;
+            m_checkpoint->save(*this, gen, pop);
+            m_gen_done = 0u;
         }
     } // end of generation loop
     if (m_verbosity) {
@@ -426,7 +482,8 @@ population cmaes::evolve(population pop) const
 /**
  * @param seed the seed controlling the algorithm stochastic behaviour
  */
-void cmaes::set_seed(unsigned seed)
+template <typename Scalar>
+void cmaes_t<Scalar>::set_seed(unsigned seed)
 {
     m_e.seed(seed);
     m_seed = seed;
@@ -436,7 +493,8 @@ void cmaes::set_seed(unsigned seed)
 /**
  * @param b batch function evaluation object
  */
-void cmaes::set_bfe(const bfe &b)
+template <typename Scalar>
+void cmaes_t<Scalar>::set_bfe(const bfe &b)
 {
     m_bfe = b;
 }
@@ -447,7 +505,8 @@ void cmaes::set_bfe(const bfe &b)
  *
  * @return a string containing extra info on the algorithm
  */
-std::string cmaes::get_extra_info() const
+template <typename Scalar>
+std::string cmaes_t<Scalar>::get_extra_info() const
 {
     std::ostringstream ss;
     stream(ss, "\tGenerations: ", m_gen);
@@ -475,6 +534,8 @@ std::string cmaes::get_extra_info() const
     stream(ss, "\n\tStopping xtol: ", m_xtol);
     stream(ss, "\n\tStopping ftol: ", m_ftol);
     stream(ss, "\n\tMemory: ", m_memory);
+    stream(ss, "\n\tSeparable: ", m_separable);
+    stream(ss, "\n\tPrecision of the matrices: ", std::is_same<Scalar, float>::value ? "single" : "double");
     stream(ss, "\n\tVerbosity: ", m_verbosity);
     stream(ss, "\n\tForce bounds: ", m_force_bounds);
     stream(ss, "\n\tSeed: ", m_seed);
@@ -482,14 +543,25 @@ std::string cmaes::get_extra_info() const
 }
 
 // Object serialization
+template <typename Scalar>
 template <typename Archive>
-void cmaes::serialize(Archive &ar, unsigned)
+void cmaes_t<Scalar>::serialize(Archive &ar, unsigned)
 {
     detail::archive(ar, m_gen, m_cc, m_cs, m_c1, m_cmu, m_sigma0, m_ftol, m_xtol, m_memory, m_force_bounds, sigma, mean,
                     variation, newpop, B, D, C, invsqrtC, pc, ps, counteval, eigeneval, m_e, m_seed, m_verbosity, m_log,
-                    m_bfe);
+                    m_bfe, m_gen_done, m_separable, diagC);
 }
 
+// The double and single precision algorithms
+template class cmaes_t<double>;
+template class cmaes_t<float>;
+
+// The checkpoints of the evolution runs archive the algorithm in binary form (see checkpoint.hpp)
+template void cmaes_t<double>::serialize(boost::archive::binary_oarchive &, unsigned);
+template void cmaes_t<double>::serialize(boost::archive::binary_iarchive &, unsigned);
+template void cmaes_t<float>::serialize(boost::archive::binary_oarchive &, unsigned);
+template void cmaes_t<float>::serialize(boost::archive::binary_iarchive &, unsigned);
+
 } // namespace pagmo
 
 //PAGMO_S11N_ALGORITHM_IMPLEMENT(pagmo::cmaes)
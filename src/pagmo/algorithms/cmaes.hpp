@@ -35,6 +35,7 @@ see https://www.gnu.org/licenses/. */
 
 #include <string>
 #include <tuple>
+#include <type_traits>
 #include <vector>
 
 #include <boost/optional.hpp>
@@ -45,7 +46,10 @@ see https://www.gnu.org/licenses/. */
 #include <pagmo/population.hpp>
 #include <pagmo/rng.hpp>
 #include <pagmo/s11n.hpp>
+#include <pagmo/types.hpp>
 
+#include "../checkpoint.hpp"
+#include "../eval_context.hpp"
 #include "../mylogger.hpp"
 
 namespace pagmo
@@ -79,10 +83,26 @@ namespace pagmo
  *    Hansen, Nikolaus. "The CMA evolution strategy: a comparing review." Towards a new evolutionary computation.
  *    Springer Berlin Heidelberg, 2006. 75-102.
  * \endverbatim
+ *
+ * The N x N matrices (the covariance matrix, its eigenvectors and eigenvalues and its inverse square root) are stored,
+ * updated and decomposed in \p Scalar, while the mean, the evolution paths, the step-size and the candidates stay in
+ * double. pagmo::cmaes is the double precision algorithm. With \p Scalar float, the matrices take half the memory and
+ * their products run on twice as many SIMD lanes, for genomes of thousands of weights. The covariance update blends
+ * positive semi-definite terms, which single precision keeps accurate to about 1e-7 relative, and the
+ * eigendecomposition clamps the eigenvalues that rounding makes negative.
+ *
+ * @tparam Scalar double or float, the precision of the N x N matrices.
  */
-class PAGMO_DLL_PUBLIC cmaes
+template <typename Scalar = double>
+class PAGMO_DLL_PUBLIC cmaes_t
 {
+    static_assert(std::is_same<Scalar, double>::value || std::is_same<Scalar, float>::value,
+                  "The N x N matrices of cmaes are stored in double or in float");
+
 public:
+    /// Type of the N x N matrices
+    typedef Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic> matrix_type;
+
     /// Single data line for the algorithm's log.
     /**
      * A log data line is a tuple consisting of:
@@ -124,9 +144,9 @@ public:
      * @param seed seed used by the internal random number generator (default is random)
      * @throws std::invalid_argument if cc, cs, c1 and cmu are not in [0, 1]
      */
-    cmaes(unsigned gen = 1, double cc = -1, double cs = -1, double c1 = -1, double cmu = -1, double sigma0 = 0.5,
-          double ftol = 1e-6, double xtol = 1e-6, bool memory = false, bool force_bounds = false, logger* log = nullptr,
-          unsigned seed = pagmo::random_device::next());
+    cmaes_t(unsigned gen = 1, double cc = -1, double cs = -1, double c1 = -1, double cmu = -1, double sigma0 = 0.5,
+            double ftol = 1e-6, double xtol = 1e-6, bool memory = false, bool force_bounds = false,
+            logger *log = nullptr, unsigned seed = pagmo::random_device::next());
 
     // Algorithm evolve method
     population evolve(population) const;
@@ -193,18 +213,91 @@ public:
         return m_gen;
     }
 
+    /// Sets the separable variant
+    /**
+     * When \p separable is true, the covariance matrix is restricted to a diagonal one (sep-CMA-ES, Ros and Hansen,
+     * 2008): its update costs O(N) instead of the O(N^2) of the rank-mu update and the O(N^3) of the
+     * eigendecomposition, and no N x N matrix is stored. The learning rates c1 and cmu, when automatic, are increased
+     * by a factor (N + 2) / 3, since only N parameters are learned. The variables are then searched along the
+     * coordinate axes only, which suits large problems with weakly dependent variables.
+     *
+     * It applies from the next call to evolve(), whose memory it resets.
+     *
+     * @param separable whether to use the separable variant.
+     */
+    void set_separable(bool separable)
+    {
+        m_separable = separable;
+    }
+
+    /// Gets the separable variant
+    /**
+     * @return whether the separable variant is used
+     */
+    bool get_separable() const
+    {
+        return m_separable;
+    }
+
+    /// Sets the initial step-size
+    /**
+     * Used by the next call to evolve() that resets the memory of the algorithm.
+     *
+     * @param sigma0 initial step-size.
+     */
+    void set_sigma0(double sigma0)
+    {
+        m_sigma0 = sigma0;
+    }
+
+    /// Gets the initial step-size
+    /**
+     * @return the initial step-size
+     */
+    double get_sigma0() const
+    {
+        return m_sigma0;
+    }
+
     /// Sets the bfe
     void set_bfe(const bfe &b);
 
+    /// Sets the evaluation context
+    /**
+     * When a context is set, evolve() stops as soon as its run budget is spent.
+     *
+     * @param context evaluation context shared with the problem, or nullptr.
+     */
+    void set_eval_context(eval_context *context)
+    {
+        m_context = context;
+    }
+
+    /// Sets the checkpoints
+    /**
+     * When set, the state of the algorithm and the population are saved at the end of every generation after which a
+     * checkpoint is due, and an algorithm restored from a checkpoint resumes after its last generation (see
+     * pagmo::checkpoint).
+     *
+     * @param cp checkpoints of the run, or nullptr.
+     */
+    void set_checkpoint(checkpoint *cp)
+    {
+        m_checkpoint = cp;
+    }
+
     /// Algorithm name
     /**
-     * One of the optional methods of any user-defined algorithm (UDA).
+     * One of the optional methods of any user-defined algorithm (UDA). The single precision algorithm has its own
+     * name, so that a checkpoint is only resumed with the precision that saved it.
      *
      * @return a string containing the algorithm name
      */
     std::string get_name() const
     {
-        return "CMA-ES: Covariance Matrix Adaptation Evolutionary Strategy";
+        return std::is_same<Scalar, float>::value
+                   ? "CMA-ES: Covariance Matrix Adaptation Evolutionary Strategy (single precision)"
+                   : "CMA-ES: Covariance Matrix Adaptation Evolutionary Strategy";
     }
 
     // Extra info
@@ -251,21 +344,31 @@ private:
     double m_xtol;
     bool m_memory;
     bool m_force_bounds;
+    bool m_separable;
     logger* m_logger;
+    eval_context *m_context;
+    checkpoint *m_checkpoint;
 
     // "Memory" data members (these are adapted during each evolve call and may be remembered if m_memory is true)
     mutable double sigma;
     mutable Eigen::VectorXd mean;
     mutable Eigen::VectorXd variation;
-    mutable std::vector<Eigen::VectorXd> newpop;
-    mutable Eigen::MatrixXd B;
-    mutable Eigen::MatrixXd D;
-    mutable Eigen::MatrixXd C;
-    mutable Eigen::MatrixXd invsqrtC;
+    // Candidates of the generation one after the other, as the bfe takes them: column-major storage of the
+    // dim x lambda matrix they are sampled into
+    mutable vector_double newpop;
+    mutable matrix_type B;
+    mutable matrix_type D;
+    // Covariance matrix, of which only the lower triangle is updated between two eigendecompositions
+    mutable matrix_type C;
+    mutable matrix_type invsqrtC;
+    // Diagonal of C, in place of B, D, C and invsqrtC in the separable variant
+    mutable Eigen::VectorXd diagC;
     mutable Eigen::VectorXd pc;
     mutable Eigen::VectorXd ps;
     mutable population::size_type counteval;
     mutable population::size_type eigeneval;
+    // Generations done when checkpointed: evolve() resumes after them
+    mutable unsigned m_gen_done;
 
     // "Common" data members
     mutable detail::random_engine_type m_e;
@@ -275,9 +378,13 @@ private:
     boost::optional<bfe> m_bfe;
 };
 
+/// CMA-ES in double precision
+using cmaes = cmaes_t<double>;
+
 } // namespace pagmo
 
 PAGMO_S11N_ALGORITHM_EXPORT_KEY(pagmo::cmaes)
+PAGMO_S11N_ALGORITHM_EXPORT_KEY(pagmo::cmaes_t<float>)
 
 #else // PAGMO_WITH_EIGEN3
 
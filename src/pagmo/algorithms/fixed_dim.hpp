@@ -0,0 +1,67 @@
+#ifndef PAGMO_ALGORITHMS_FIXED_DIM_HPP
+#define PAGMO_ALGORITHMS_FIXED_DIM_HPP
+
+#include <type_traits>
+#include <utility>
+
+#include <pagmo/detail/eigen.hpp>
+
+// Genome sizes for which the kernels of the evolution strategies are compiled with fixed-size Eigen types: a
+// comma-separated list, set by the ES_FIXED_DIMS CMake variable, of sizes up to max_fixed_dim. Other sizes take the
+// dynamic path.
+#ifndef PAGMO_ES_FIXED_DIMS
+#define PAGMO_ES_FIXED_DIMS 30, 50
+#endif
+
+namespace pagmo
+{
+namespace detail
+{
+
+/// Largest dimension allowed in PAGMO_ES_FIXED_DIMS
+/**
+ * The fixed-size matrices and the temporaries of the kernels live on the stack: a 64 x 64 matrix of doubles takes
+ * 32 KB, while a 353 x 353 one would take about 1 MB and overflow it. Every fixed dimension also compiles another copy
+ * of the kernels. Larger genomes should use the dynamic path, where the fixed-size gain is negligible anyway.
+ */
+constexpr int max_fixed_dim = 64;
+
+/// Vector, square matrix and set of columns of \p Dim rows, Eigen::Dynamic if the dimension is not fixed
+template <int Dim, typename Scalar = double>
+using fixed_vector = Eigen::Matrix<Scalar, Dim, 1>;
+template <int Dim, typename Scalar = double>
+using fixed_matrix = Eigen::Matrix<Scalar, Dim, Dim>;
+template <int Dim, typename Scalar = double>
+using fixed_columns = Eigen::Matrix<Scalar, Dim, Eigen::Dynamic>;
+
+template <typename F, int... Dims>
+void with_fixed_dim(unsigned dim, F &&f, std::integer_sequence<int, Dims...>)
+{
+    static_assert(((Dims > 0 && Dims <= max_fixed_dim) && ...),
+                  "ES_FIXED_DIMS must list sizes from 1 to max_fixed_dim: use the dynamic path for larger genomes");
+    bool fixed = ((dim == static_cast<unsigned>(Dims) && (f(std::integral_constant<int, Dims>{}), true)) || ...);
+    if (!fixed) {
+        f(std::integral_constant<int, Eigen::Dynamic>{});
+    }
+}
+
+/// Kernel specialised on the dimension
+/**
+ * Calls \p f with a <tt>std::integral_constant<int, Dim></tt>, where \p Dim is \p dim if it is one of
+ * PAGMO_ES_FIXED_DIMS, or Eigen::Dynamic otherwise. \p f is a generic lambda that maps the dynamic data of the
+ * algorithm onto fixed_vector<Dim> and fixed_matrix<Dim>, so that the kernel is compiled once for each fixed dimension,
+ * with the products unrolled and the temporaries on the stack, and once for the other dimensions.
+ *
+ * @param dim the dimension of the problem.
+ * @param f the kernel.
+ */
+template <typename F>
+void with_fixed_dim(unsigned dim, F &&f)
+{
+    with_fixed_dim(dim, std::forward<F>(f), std::integer_sequence<int, PAGMO_ES_FIXED_DIMS>{});
+}
+
+} // namespace detail
+} // namespace pagmo
+
+#endif
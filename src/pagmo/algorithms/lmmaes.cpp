@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pagmo/algorithm.hpp>
+#include "lmmaes.hpp"
+#include <pagmo/detail/custom_comparisons.hpp>
+#include <pagmo/detail/eigen.hpp>
+#include <pagmo/detail/eigen_s11n.hpp>
+#include <pagmo/exceptions.hpp>
+#include <pagmo/io.hpp>
+#include <pagmo/population.hpp>
+#include <pagmo/s11n.hpp>
+#include <pagmo/types.hpp>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+
+// NOTE: apparently this must be included *after*
+// the other serialization headers.
+#include <boost/serialization/optional.hpp>
+
+namespace pagmo
+{
+
+lmmaes::lmmaes(unsigned gen, unsigned m, double sigma0, double ftol, double xtol, bool memory, bool force_bounds,
+               logger *log, unsigned seed)
+    : m_gen(gen), m_m(m), m_sigma0(sigma0), m_ftol(ftol), m_xtol(xtol), m_memory(memory),
+      m_force_bounds(force_bounds), m_logger(log), m_context(nullptr), m_checkpoint(nullptr), m_e(seed),
+      m_seed(seed), m_verbosity(0u)
+{
+    if (sigma0 <= 0.) {
+        pagmo_throw(std::invalid_argument,
+                    "sigma0 needs to be positive, a value of " + std::to_string(sigma0) + " was detected");
+    }
+    // Initialize explicitly the algorithm memory
+    sigma = m_sigma0;
+    mean = Eigen::VectorXd::Zero(1);
+    M = Eigen::MatrixXd::Zero(1, 1);
+    ps = Eigen::VectorXd::Zero(1);
+    t = 0u;
+    m_gen_done = 0u;
+}
+
+/// Algorithm evolve method
+/**
+ * Evolves the population for a maximum number of generations, until one of
+ * tolerances set on the population flatness (x_tol, f_tol) are met.
+ *
+ * @param pop population to be evolved
+ * @return evolved population
+ * @throws std::invalid_argument if the problem is multi-objective or constrained
+ * @throws std::invalid_argument if the problem is unbounded
+ * @throws std::invalid_argument if the population size is not at least 5
+ * @throws std::invalid_argument if the evaluation context is in the seeded sampling mode
+ */
+population lmmaes::evolve(population pop) const
+{
+    // We store some useful variables
+    const auto &prob = pop.get_problem();
+    auto dim = prob.get_nx();
+    const auto bounds = prob.get_bounds();
+    const auto &lb = bounds.first;
+    const auto &ub = bounds.second;
+    auto lam = pop.size();
+    auto mu = lam / 2u;
+    auto fevals0 = prob.get_fevals(); // discount for the already made fevals
+    auto count = 1u;                  // regulates the screen output
+
+    // PREAMBLE--------------------------------------------------
+    // Checks on the problem type
+    if (prob.get_nc() != 0u) {
+        pagmo_throw(std::invalid_argument, "Non linear constraints detected in " + prob.get_name() + " instance. "
+                                               + get_name() + " cannot deal with them");
+    }
+    if (prob.get_nf() != 1u) {
+        pagmo_throw(std::invalid_argument, "Multiple objectives detected in " + prob.get_name() + " instance. "
+                                               + get_name() + " cannot deal with them");
+    }
+    if (lam < 5u) {
+        pagmo_throw(std::invalid_argument, get_name() + " needs at least 5 individuals in the population, "
+                                               + std::to_string(lam) + " detected");
+    }
+    for (decltype(dim) j = 0u; j < dim; ++j) {
+        if (!std::isfinite(lb[j]) || !std::isfinite(ub[j])) {
+            pagmo_throw(std::invalid_argument, "Infinite bounds detected, " + get_name() + " cannot deal with them");
+        }
+    }
+    if (m_context && m_context->get_seeded_sampling()) {
+        pagmo_throw(std::invalid_argument, get_name() + " does not support the seeded sampling mode");
+    }
+    // Get out if there is nothing to do.
+    if (m_gen == 0u) {
+        return pop;
+    }
+    // -----------------------------------------------------------
+
+    // No throws, all valid: we clear the logs
+    m_log.clear();
+
+    std::normal_distribution<double> normally_distributed_number(0., 1.);
+    // Setting coefficients for Selection
+    Eigen::VectorXd weights(_(mu));
+    for (decltype(weights.rows()) i = 0; i < weights.rows(); ++i) {
+        weights(i) = std::log(static_cast<double>(mu) + 0.5) - std::log(static_cast<double>(i) + 1.);
+    }
+    weights /= weights.sum();
+    double mueff = 1. / (weights.transpose() * weights);
+
+    // Setting coefficients for Adaptation. The rates of the paper are meant for large N: they are capped at 1 so
+    // that small problems still run.
+    double N = static_cast<double>(dim);
+    auto m = m_m != 0u ? m_m : 4u + static_cast<unsigned>(std::floor(3. * std::log(N)));
+    double cs = std::min(1., 2. * static_cast<double>(lam) / N);
+    Eigen::VectorXd cd(_(m)), cc(_(m));
+    for (decltype(m) j = 0u; j < m; ++j) {
+        cd(_(j)) = std::min(1., 1. / (std::pow(1.5, static_cast<double>(j)) * N));
+        cc(_(j)) = std::min(1., static_cast<double>(lam) / (std::pow(4., static_cast<double>(j)) * N));
+    }
+
+    // If the algorithm is called for the first time on this problem dimension or if m_memory is false we
+    // erase the memory of past calls, unless the algorithm was restored from a checkpoint
+    if ((mean.rows() != _(dim)) || (M.rows() != _(dim)) || (M.cols() != _(m))
+        || (m_memory == false && m_gen_done == 0u)) {
+        sigma = m_sigma0;
+        mean.resize(_(dim));
+        auto idx_b = pop.best_idx();
+        for (decltype(dim) i = 0u; i < dim; ++i) {
+            mean(_(i)) = pop.get_x()[idx_b][i];
+        }
+        M = Eigen::MatrixXd::Zero(_(dim), _(m));
+        ps = Eigen::VectorXd::Zero(_(dim));
+        t = 0u;
+        m_gen_done = 0u;
+    }
+    auto first_gen = m_gen_done + 1u;
+    m_gen_done = 0u;
+
+    if (m_verbosity > 0u) {
+        std::cout << "LM-MA-ES 4 PaGMO: " << std::endl;
+        std::cout << "mu: " << mu << " - lambda: " << lam << " - mueff: " << mueff << " - N: " << N << " - m: " << m
+                  << std::endl;
+        std::cout << "cs: " << cs << " - cd: " << cd(0) << " - cc: " << cc(0) << " - sigma: " << sigma << std::endl;
+
+        if (m_logger && m_logger->is_genome() && first_gen == 1u) {
+            m_logger->save_hist_score(0, &pop);
+        }
+    }
+
+    // Some buffers: the normal vectors and their transformations, one per column
+    Eigen::MatrixXd Z(_(dim), _(lam));
+    Eigen::MatrixXd Dz(_(dim), _(lam));
+    Eigen::VectorXd variation(_(dim));
+    vector_double dumb(dim, 0.);
+
+    // ----------------------------------------------//
+    // HERE WE START THE JUICE OF THE ALGORITHM      //
+    // ----------------------------------------------//
+    for (decltype(m_gen) gen = first_gen; gen <= m_gen; ++gen) {
+        // 0 - Exit condition on the run budget
+        if (m_context && m_context->budget_exhausted()) {
+            if (m_verbosity > 0u) {
+                std::cout << "Exit condition -- budget = " << m_context->get_run_budget() << std::endl;
+            }
+            return pop;
+        }
+        // 1 - We generate lam new directions, each transformed by the direction vectors in O(m N)
+        auto n_vectors = static_cast<Eigen::DenseIndex>(std::min<unsigned long long>(t, m));
+        for (decltype(lam) i = 0u; i < lam; ++i) {
+            for (decltype(dim) j = 0u; j < dim; ++j) {
+                Z(_(j), _(i)) = normally_distributed_number(m_e);
+            }
+            Dz.col(_(i)) = Z.col(_(i));
+            for (Eigen::DenseIndex j = 0; j < n_vectors; ++j) {
+                Dz.col(_(i)) = (1. - cd(j)) * Dz.col(_(i)) + cd(j) * M.col(j) * M.col(j).dot(Dz.col(_(i)));
+            }
+        }
+        variation = sigma * Dz.col(_(lam - 1u));
+
+        // 1bis - Check the exit conditions and logs
+        // Exit condition on xtol
+        {
+            if (variation.norm() < m_xtol) {
+                if (m_verbosity > 0u) {
+                    std::cout << "Exit condition -- xtol < " << m_xtol << std::endl;
+                }
+                return pop;
+            }
+            // Exit condition on ftol
+            auto idx_b = pop.best_idx();
+            auto idx_w = pop.worst_idx();
+            double delta_f = std::abs(pop.get_f()[idx_b][0] - pop.get_f()[idx_w][0]);
+            if (delta_f < m_ftol) {
+                if (m_verbosity) {
+                    std::cout << "Exit condition -- ftol < " << m_ftol << std::endl;
+                }
+                return pop;
+            }
+        }
+
+        // 1bis - Logs and prints (verbosity modes > 1: a line is added every m_verbosity generations)
+        if (m_verbosity > 0u) {
+            // Every m_verbosity generations print a log line
+            if (gen % m_verbosity == 1u || m_verbosity == 1u) {
+                auto dx = variation.norm();
+                auto idx_b = pop.best_idx();
+                auto idx_w = pop.worst_idx();
+                auto df = std::abs(pop.get_f()[idx_b][0] - pop.get_f()[idx_w][0]);
+                // Every 50 lines print the column names
+                if (count % 50u == 1u) {
+                    print("\n", std::setw(7), "Gen:", std::setw(15), "Fevals:", std::setw(15), "Best:", std::setw(15),
+                          "dx:", std::setw(15), "df:", std::setw(15), "sigma:", '\n');
+                }
+                print(std::setw(7), gen, std::setw(15), prob.get_fevals() - fevals0, std::setw(15),
+                      pop.get_f()[idx_b][0], std::setw(15), dx, std::setw(15), df, std::setw(15), sigma, '\n');
+                ++count;
+                // Logs
+                m_log.emplace_back(gen, prob.get_fevals() - fevals0, pop.get_f()[idx_b][0], dx, df, sigma);
+
+                if (m_logger && m_logger->is_genome()) {
+                    m_logger->save_hist_score(gen, &pop);
+                    std::vector<double> mean_val(mean.data(), mean.data() + mean.size());
+                    m_logger->save_to_file(gen, &mean_val[0], &pop);
+                }
+                if (m_logger && m_context) {
+                    m_logger->save_run_table(gen, *m_context);
+                }
+            }
+        }
+        // 2 - We build the candidates, fixing the bounds if requested. The update uses the unbounded directions.
+        vector_double decision_vectors(lam * dim);
+        for (decltype(lam) i = 0u; i < lam; ++i) {
+            for (decltype(dim) j = 0u; j < dim; ++j) {
+                auto x = mean(_(j)) + sigma * Dz(_(j), _(i));
+                if (m_force_bounds) {
+                    x = std::min(std::max(x, lb[j]), ub[j]);
+                }
+                decision_vectors[i * dim + j] = x;
+            }
+        }
+        // 3 - We Evaluate the new population (if the problem is stochastic change seed first)
+        if (prob.is_stochastic()) {
+            pop.get_problem().set_seed(std::uniform_int_distribution<unsigned>()(m_e));
+        }
+        if (m_bfe) {
+            auto fitnesses = (*m_bfe)(prob, decision_vectors);
+            for (decltype(lam) i = 0u; i < lam; ++i) {
+                std::copy(decision_vectors.begin() + static_cast<std::ptrdiff_t>(i * dim),
+                          decision_vectors.begin() + static_cast<std::ptrdiff_t>((i + 1u) * dim), dumb.begin());
+                pop.set_xf(i, dumb, {fitnesses[i]});
+            }
+        } else {
+            for (decltype(lam) i = 0u; i < lam; ++i) {
+                std::copy(decision_vectors.begin() + static_cast<std::ptrdiff_t>(i * dim),
+                          decision_vectors.begin() + static_cast<std::ptrdiff_t>((i + 1u) * dim), dumb.begin());
+                pop.set_x(i, dumb);
+            }
+        }
+        // 4 - We rank the new population
+        std::vector<population::size_type> best_idx(lam);
+        std::iota(best_idx.begin(), best_idx.end(), population::size_type(0));
+        std::sort(best_idx.begin(), best_idx.end(), [&pop](population::size_type idx1, population::size_type idx2) {
+            return detail::less_than_f(pop.get_f()[idx1][0], pop.get_f()[idx2][0]);
+        });
+        // 5 - Recombine the normal vectors and the directions of the elite
+        Eigen::VectorXd zw = Eigen::VectorXd::Zero(_(dim));
+        Eigen::VectorXd dw = Eigen::VectorXd::Zero(_(dim));
+        for (decltype(mu) i = 0u; i < mu; ++i) {
+            zw += weights(_(i)) * Z.col(_(best_idx[i]));
+            dw += weights(_(i)) * Dz.col(_(best_idx[i]));
+        }
+        // 6 - Update the evolution path of sigma and the direction vectors
+        ps = (1. - cs) * ps + std::sqrt(mueff * cs * (2. - cs)) * zw;
+        for (decltype(m) j = 0u; j < m; ++j) {
+            M.col(_(j)) = (1. - cc(_(j))) * M.col(_(j)) + std::sqrt(mueff * cc(_(j)) * (2. - cc(_(j)))) * zw;
+        }
+        // 7 - Move the mean and adapt sigma
+        mean += sigma * dw;
+        sigma *= std::exp(cs / 2. * (ps.squaredNorm() / N - 1.));
+        ++t;
+        // 8 - Save a checkpoint, from which evolve() resumes after this generation
+        if (m_checkpoint && m_checkpoint->due(gen)) {
+            m_gen_done = gen;
+            m_checkpoint->save(*this, gen, pop);
+            m_gen_done = 0u;
+        }
+    } // end of generation loop
+    if (m_verbosity) {
+        std::cout << "Exit condition -- generations = " << m_gen << std::endl;
+    }
+    return pop;
+}
+
+/// Sets the seed
+/**
+ * @param seed the seed controlling the algorithm stochastic behaviour
+ */
+void lmmaes::set_seed(unsigned seed)
+{
+    m_e.seed(seed);
+    m_seed = seed;
+}
+
+/// Sets the bfe
+/**
+ * @param b bfe used to evaluate the population of each generation
+ */
+void lmmaes::set_bfe(const bfe &b)
+{
+    m_bfe = b;
+}
+
+/// Extra info
+/**
+ * @return a string containing extra info on the algorithm
+ */
+std::string lmmaes::get_extra_info() const
+{
+    std::ostringstream ss;
+    stream(ss, "\tGenerations: ", m_gen);
+    stream(ss, "\n\tDirection vectors: ");
+    if (m_m == 0u)
+        stream(ss, "auto");
+    else
+        stream(ss, m_m);
+    stream(ss, "\n\tsigma0: ", m_sigma0);
+    stream(ss, "\n\tStopping xtol: ", m_xtol);
+    stream(ss, "\n\tStopping ftol: ", m_ftol);
+    stream(ss, "\n\tMemory: ", m_memory);
+    stream(ss, "\n\tVerbosity: ", m_verbosity);
+    stream(ss, "\n\tForce bounds: ", m_force_bounds);
+    stream(ss, "\n\tSeed: ", m_seed);
+    return ss.str();
+}
+
+// Object serialization
+template <typename Archive>
+void lmmaes::serialize(Archive &ar, unsigned)
+{
+    detail::archive(ar, m_gen, m_m, m_sigma0, m_ftol, m_xtol, m_memory, m_force_bounds, sigma, mean, M, ps, t, m_e,
+                    m_seed, m_verbosity, m_log, m_bfe, m_gen_done);
+}
+
+// The checkpoints of the evolution runs archive the algorithm in binary form (see checkpoint.hpp)
+template void lmmaes::serialize(boost::archive::binary_oarchive &, unsigned);
+template void lmmaes::serialize(boost::archive::binary_iarchive &, unsigned);
+
+} // namespace pagmo
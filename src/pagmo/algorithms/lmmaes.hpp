@@ -0,0 +1,234 @@
+#ifndef PAGMO_ALGORITHMS_LMMAES_HPP
+#define PAGMO_ALGORITHMS_LMMAES_HPP
+
+#include <pagmo/config.hpp>
+
+#if defined(PAGMO_WITH_EIGEN3)
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include <pagmo/algorithm.hpp>
+#include <pagmo/bfe.hpp>
+#include <pagmo/detail/eigen.hpp>
+#include <pagmo/detail/visibility.hpp>
+#include <pagmo/population.hpp>
+#include <pagmo/rng.hpp>
+#include <pagmo/s11n.hpp>
+
+#include "../checkpoint.hpp"
+#include "../eval_context.hpp"
+#include "../mylogger.hpp"
+
+namespace pagmo
+{
+/// Limited-Memory Matrix Adaptation Evolution Strategy
+/**
+ * LM-MA-ES adapts the search distribution of CMA-ES without storing a covariance matrix: the transformation of the
+ * normal vectors is the product of \p m rank-one updates of the identity, built from \p m direction vectors that are
+ * evolution paths of the selected steps at geometrically spaced time horizons. Sampling a candidate costs O(mN) and
+ * the state O(mN) memory, with \p m about 4 + 3 ln N, so that it handles genomes of tens of thousands of weights,
+ * where the N x N matrices of pagmo::cmaes and pagmo::xnes do not fit.
+ *
+ * The step-size is adapted by cumulative step-size adaptation, as in pagmo::cmaes.
+ *
+ * \verbatim embed:rst:leading-asterisk
+ * .. note::
+ *
+ *    The seeded sampling mode of the evaluation context (see eval_context::set_seeded_sampling()) needs a dense
+ *    transformation matrix, and is not supported.
+ *
+ * .. seealso::
+ *
+ *    Loshchilov, Ilya, Tobias Glasmachers, and Hans-Georg Beyer. "Large scale black-box optimization by limited-memory
+ *    matrix adaptation." IEEE Transactions on Evolutionary Computation 23.2 (2019): 353-358.
+ * \endverbatim
+ */
+class PAGMO_DLL_PUBLIC lmmaes
+{
+public:
+    /// Single data line for the algorithm's log.
+    /**
+     * A log data line is a tuple consisting of:
+     * - the generation number,
+     * - the number of function evaluations,
+     * - the best fitness in the population,
+     * - the norm of the last mutant vector,
+     * - the population flatness evaluated as the distance between the fitness of the best and of the worst individual,
+     * - the step-size.
+     */
+    typedef std::tuple<unsigned, unsigned long long, double, double, double, double> log_line_type;
+
+    /// Log type.
+    typedef std::vector<log_line_type> log_type;
+
+    /// Constructor.
+    /**
+     * @param gen number of generations.
+     * @param m number of direction vectors, 0 for 4 + 3 ln N.
+     * @param sigma0 initial step-size.
+     * @param ftol stopping criteria on the f tolerance (default is 1e-6).
+     * @param xtol stopping criteria on the x tolerance (default is 1e-6).
+     * @param memory when true the adapted parameters are not reset between successive calls to the evolve method.
+     * @param force_bounds when true the box bounds are enforced.
+     * @param log logger of the scores and of the means.
+     * @param seed seed used by the internal random number generator (default is random).
+     *
+     * @throws std::invalid_argument if \p sigma0 is not positive.
+     */
+    lmmaes(unsigned gen = 1, unsigned m = 0, double sigma0 = 0.5, double ftol = 1e-6, double xtol = 1e-6,
+           bool memory = false, bool force_bounds = false, logger *log = nullptr,
+           unsigned seed = pagmo::random_device::next());
+
+    // Algorithm evolve method
+    population evolve(population) const;
+
+    // Sets the seed
+    void set_seed(unsigned);
+
+    /// Gets the seed
+    unsigned get_seed() const
+    {
+        return m_seed;
+    }
+
+    /// Sets the algorithm verbosity
+    /**
+     * - 0: no verbosity
+     * - >0: will print and log one line each \p level generations, with the columns of pagmo::cmaes.
+     *
+     * @param level verbosity level
+     */
+    void set_verbosity(unsigned level)
+    {
+        m_verbosity = level;
+    }
+
+    /// Gets the verbosity level
+    unsigned get_verbosity() const
+    {
+        return m_verbosity;
+    }
+
+    /// Gets the generations
+    unsigned get_gen() const
+    {
+        return m_gen;
+    }
+
+    /// Sets the initial step-size
+    /**
+     * Used by the next call to evolve() that resets the memory of the algorithm.
+     *
+     * @param sigma0 initial step-size.
+     */
+    void set_sigma0(double sigma0)
+    {
+        m_sigma0 = sigma0;
+    }
+
+    /// Gets the initial step-size
+    double get_sigma0() const
+    {
+        return m_sigma0;
+    }
+
+    /// Sets the bfe
+    void set_bfe(const bfe &b);
+
+    /// Sets the evaluation context
+    /**
+     * When a context is set, evolve() stops as soon as its run budget is spent.
+     *
+     * @param context evaluation context shared with the problem, or nullptr.
+     */
+    void set_eval_context(eval_context *context)
+    {
+        m_context = context;
+    }
+
+    /// Sets the checkpoints
+    /**
+     * When set, the state of the algorithm and the population are saved at the end of every generation after which a
+     * checkpoint is due, and an algorithm restored from a checkpoint resumes after its last generation (see
+     * pagmo::checkpoint).
+     *
+     * @param cp checkpoints of the run, or nullptr.
+     */
+    void set_checkpoint(checkpoint *cp)
+    {
+        m_checkpoint = cp;
+    }
+
+    /// Algorithm name
+    std::string get_name() const
+    {
+        return "LM-MA-ES: Limited-Memory Matrix Adaptation Evolution Strategy";
+    }
+
+    // Extra info
+    std::string get_extra_info() const;
+
+    /// Get log
+    const log_type &get_log() const
+    {
+        return m_log;
+    }
+
+private:
+    // Object serialization
+    friend class boost::serialization::access;
+    template <typename Archive>
+    void serialize(Archive &, unsigned);
+
+    template <typename I>
+    static Eigen::DenseIndex _(I n)
+    {
+        return static_cast<Eigen::DenseIndex>(n);
+    }
+
+    // Data members
+    unsigned m_gen;
+    unsigned m_m;
+    double m_sigma0;
+    double m_ftol;
+    double m_xtol;
+    bool m_memory;
+    bool m_force_bounds;
+    logger *m_logger;
+    eval_context *m_context;
+    checkpoint *m_checkpoint;
+
+    // "Memory" data members (these are adapted during each evolve call and may be remembered if m_memory is true)
+    mutable double sigma;
+    mutable Eigen::VectorXd mean;
+    // Direction vectors, one per column
+    mutable Eigen::MatrixXd M;
+    mutable Eigen::VectorXd ps;
+    // Generations since the memory was reset, which bounds the direction vectors in use
+    mutable unsigned long long t;
+    // Generations done when checkpointed: evolve() resumes after them
+    mutable unsigned m_gen_done;
+
+    // "Common" data members
+    mutable detail::random_engine_type m_e;
+    unsigned m_seed;
+    unsigned m_verbosity;
+    mutable log_type m_log;
+    boost::optional<bfe> m_bfe;
+};
+
+} // namespace pagmo
+
+PAGMO_S11N_ALGORITHM_EXPORT_KEY(pagmo::lmmaes)
+
+#else // PAGMO_WITH_EIGEN3
+
+#error The lmmaes.hpp header was included, but pagmo was not compiled with eigen3 support
+
+#endif // PAGMO_WITH_EIGEN3
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef PAGMO_ALGORITHMS_NES_HPP
+#define PAGMO_ALGORITHMS_NES_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include <pagmo/bfe.hpp>
+#include <pagmo/detail/eigen.hpp>
+#include <pagmo/io.hpp>
+#include <pagmo/population.hpp>
+#include <pagmo/types.hpp>
+
+#include "../eval_context.hpp"
+#include "../mylogger.hpp"
+
+namespace pagmo
+{
+/// Helpers shared by the Natural Evolution Strategies, pagmo::xnes and pagmo::snes
+namespace nes
+{
+
+/// Fitness shaping utilities
+/**
+ * The \p i-th best of \p lam candidates weighs <tt>max(0, ln(lam / 2 + 1) - ln(i + 1))</tt>, normalized to sum to 1,
+ * minus the uniform baseline <tt>1 / lam</tt>: the utilities sum to 0 and only the ranks of the fitnesses matter.
+ *
+ * @param lam population size.
+ *
+ * @return the utilities, from the best candidate to the worst.
+ */
+inline std::vector<double> utilities(population::size_type lam)
+{
+    double lam_d = static_cast<double>(lam);
+    std::vector<double> u(lam);
+    for (decltype(u.size()) i = 0u; i < u.size(); ++i) {
+        u[i] = std::max(0., std::log(lam_d / 2. + 1.) - std::log(i + 1));
+    }
+    double sum = 0.;
+    for (decltype(u.size()) i = 0u; i < u.size(); ++i) {
+        sum += u[i];
+    }
+    for (decltype(u.size()) i = 0u; i < u.size(); ++i) {
+        u[i] = u[i] / sum - 1. / lam_d; // Give an option to turn off the uniform baseline (i.e. -1/lam_d) ?
+    }
+    return u;
+}
+
+/// Sampling batch of a generation in the seeded sampling mode
+/**
+ * Sets the mean, the bounds and the number of seeds of the sampling batch of \p context: the caller sets the shape of
+ * the distribution and draws the seeds.
+ *
+ * @param context evaluation context, or nullptr.
+ * @param mean the mean of the search distribution.
+ * @param lb the lower bounds.
+ * @param ub the upper bounds.
+ * @param force_bounds whether the candidates are clamped to the bounds.
+ * @param lam population size.
+ *
+ * @return the sampling batch, or nullptr if \p context is not set or not in the seeded sampling mode.
+ */
+inline sampling_batch *seeded_batch(eval_context *context, const Eigen::VectorXd &mean, const vector_double &lb,
+                                    const vector_double &ub, bool force_bounds, population::size_type lam)
+{
+    if (!context || !context->get_seeded_sampling()) {
+        return nullptr;
+    }
+    auto dim = static_cast<Eigen::DenseIndex>(lb.size());
+    auto &batch = context->get_sampling_batch();
+    batch.state.mean = mean;
+    batch.state.force_bounds = force_bounds;
+    batch.state.lb = Eigen::Map<const Eigen::VectorXd>(lb.data(), dim);
+    batch.state.ub = Eigen::Map<const Eigen::VectorXd>(ub.data(), dim);
+    batch.seeds.resize(lam);
+    return &batch;
+}
+
+/// Evaluation of the candidates of a generation
+/**
+ * The candidates are clamped to the bounds if \p clamp is set (sample_candidate() clamps them already in the seeded
+ * sampling mode), then set in the population with their fitnesses, computed in one batch if \p b is set.
+ *
+ * @param pop the population, of the size of \p x.
+ * @param b batch fitness evaluator, or none.
+ * @param x the candidates.
+ * @param clamp whether the candidates are clamped to the bounds.
+ */
+inline void evaluate(population &pop, const boost::optional<bfe> &b, std::vector<Eigen::VectorXd> &x, bool clamp)
+{
+    const auto &prob = pop.get_problem();
+    const auto bounds = prob.get_bounds();
+    auto dim = prob.get_nx();
+    vector_double dumb(dim, 0.);
+    if (clamp) {
+        // Note that this screws up the natural gradient and worsen performances considerably.
+        for (auto &xi : x) {
+            for (decltype(dim) j = 0u; j < dim; ++j) {
+                auto jj = static_cast<Eigen::DenseIndex>(j);
+                xi(jj) = std::min(std::max(xi(jj), bounds.first[j]), bounds.second[j]);
+            }
+        }
+    }
+    if (!b) {
+        // bfe not available
+        for (decltype(x.size()) i = 0u; i < x.size(); ++i) {
+            std::copy(x[i].data(), x[i].data() + dim, dumb.begin());
+            pop.set_x(i, dumb);
+        }
+        return;
+    }
+    // bfe is available:
+    vector_double decision_vectors(x.size() * dim);
+    for (decltype(x.size()) i = 0u; i < x.size(); ++i) {
+        std::copy(x[i].data(), x[i].data() + dim, decision_vectors.begin() + i * dim);
+    }
+    auto fitnesses = (*b)(prob, decision_vectors);
+    for (decltype(x.size()) i = 0u; i < x.size(); ++i) {
+        std::copy(x[i].data(), x[i].data() + dim, dumb.begin());
+        pop.set_xf(i, dumb, {fitnesses[i]});
+    }
+}
+
+/// Screen output and log line of a generation
+/**
+ * Prints the generation, the fitness evaluations, the best fitness, the population flatness in chromosome and in
+ * fitness and sigma, with the column names every 50 lines, and appends them to the log of the algorithm.
+ *
+ * @param log the log of the algorithm.
+ * @param count number of lines printed so far, plus one.
+ * @param gen the generation number.
+ * @param fevals fitness evaluations since the start of the evolution.
+ * @param pop the population of the generation.
+ * @param dx the population flatness in chromosome.
+ * @param sigma the step-size.
+ */
+template <typename Log>
+inline void print_generation(Log &log, unsigned &count, unsigned gen, unsigned long long fevals,
+                             const population &pop, double dx, double sigma)
+{
+    // The population flatness in fitness
+    auto idx_b = pop.best_idx();
+    auto idx_w = pop.worst_idx();
+    auto df = std::abs(pop.get_f()[idx_b][0] - pop.get_f()[idx_w][0]);
+    // Every 50 lines print the column names
+    if (count % 50u == 1u) {
+        print("\n", std::setw(7), "Gen:", std::setw(15), "Fevals:", std::setw(15), "Best:", std::setw(15), "dx:",
+              std::setw(15), "df:", std::setw(15), "sigma:", '\n');
+    }
+    print(std::setw(7), gen, std::setw(15), fevals, std::setw(15), pop.get_f()[idx_b][0], std::setw(15), dx,
+          std::setw(15), df, std::setw(15), sigma, '\n');
+    ++count;
+    log.emplace_back(gen, fevals, pop.get_f()[idx_b][0], dx, df, sigma);
+}
+
+/// Logs of a generation
+/**
+ * Saves the best score, the champion and mean genomes and the run table of the generation, as far as the logger and
+ * the context are set.
+ *
+ * @param log logger of the scores and of the means, or nullptr.
+ * @param context evaluation context, or nullptr.
+ * @param gen the generation number.
+ * @param mean the mean of the search distribution.
+ * @param pop the population of the generation.
+ */
+inline void log_generation(logger *log, const eval_context *context, unsigned gen, const Eigen::VectorXd &mean,
+                           population &pop)
+{
+    if (!log) {
+        return;
+    }
+    if (log->is_genome()) {
+        log->save_hist_score(gen, &pop);
+        std::vector<double> mean_val(mean.data(), mean.data() + mean.size());
+        log->save_to_file(gen, &mean_val[0], &pop);
+    }
+    if (context) {
+        log->save_run_table(gen, *context);
+    }
+}
+
+} // namespace nes
+} // namespace pagmo
+
+#endif
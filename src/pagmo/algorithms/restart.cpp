@@ -0,0 +1,234 @@
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pagmo/algorithm.hpp>
+#include "restart.hpp"
+#include <pagmo/exceptions.hpp>
+#include <pagmo/io.hpp>
+#include <pagmo/population.hpp>
+#include <pagmo/s11n.hpp>
+#include <pagmo/types.hpp>
+
+// NOTE: apparently this must be included *after*
+// the other serialization headers.
+#include <boost/serialization/optional.hpp>
+
+#include "../problems/mpi_argos.hpp"
+
+namespace pagmo
+{
+
+restart::restart(const algorithm &algo, bool bipop, unsigned max_restarts, logger *log, unsigned seed)
+    : m_algorithm(algo), m_bipop(bipop), m_max_restarts(max_restarts), m_logger(log), m_context(nullptr), m_e(seed),
+      m_seed(seed), m_verbosity(0u), m_log()
+{
+    if (!visit_es(m_algorithm, [](const auto &) {})) {
+        pagmo_throw(std::invalid_argument, "The restarted algorithm must be cmaes, xnes, snes or lmmaes, while "
+                                               + m_algorithm.get_name() + " was given");
+    }
+}
+
+/// Algorithm evolve method
+/**
+ * Evolves the population with the restarted algorithm, then restarts it from new random populations until the run
+ * budget is spent or the maximum number of restarts is reached.
+ *
+ * @param pop population to be evolved, whose size is the initial population size of the restarts.
+ *
+ * @return the population evolved by the last restart, in which the worst individual is replaced by the champion of
+ * all the restarts if it is better than its own.
+ *
+ * @throws std::invalid_argument if the problem is multi-objective or constrained, or if the population is empty.
+ */
+population restart::evolve(population pop) const
+{
+    const auto &prob = pop.get_problem();
+    auto dim = prob.get_nx();
+    const auto bounds = prob.get_bounds();
+    const auto &lb = bounds.first;
+    const auto &ub = bounds.second;
+    auto lam0 = pop.size();
+
+    if (prob.get_nc() != 0u) {
+        pagmo_throw(std::invalid_argument, "Non linear constraints detected in " + prob.get_name() + " instance. "
+                                               + get_name() + " cannot deal with them");
+    }
+    if (prob.get_nf() != 1u) {
+        pagmo_throw(std::invalid_argument, "Multiple objectives detected in " + prob.get_name() + " instance. "
+                                               + get_name() + " cannot deal with them");
+    }
+    if (lam0 == 0u) {
+        pagmo_throw(std::invalid_argument, get_name() + " needs at least one individual in the population");
+    }
+
+    // Runs done so far, the budget unit of the BIPOP regimes
+    auto runs_done = [this, &prob]() -> unsigned long long {
+        return m_context ? m_context->get_runs() : prob.get_fevals();
+    };
+    auto budget_left = [this]() { return !m_context || !m_context->budget_exhausted(); };
+
+    m_log.clear();
+    double sigma0 = 0.;
+    visit_es(m_algorithm, [&sigma0](const auto &uda) { sigma0 = uda.get_sigma0(); });
+    vector_double best_x;
+    double best_f = std::numeric_limits<double>::infinity();
+    population::size_type lam_large = lam0;
+    unsigned long long runs_large = 0u, runs_small = 0u;
+
+    if (m_verbosity > 0u) {
+        std::cout << get_name() << ": " << std::endl;
+        print(std::setw(9), "Restart:", std::setw(9), "Regime:", std::setw(15), "Runs:", std::setw(9), "lambda:",
+              std::setw(15), "sigma0:", std::setw(15), "Best:", '\n');
+    }
+
+    for (unsigned n = 0u; n <= m_max_restarts && budget_left(); ++n) {
+        // 1 - We choose the regime of the restart, the initial run counting as a large one
+        std::string regime = "initial";
+        auto lam = lam0;
+        auto sigma = sigma0;
+        if (n > 0u) {
+            std::uniform_real_distribution<double> drng(0., 1.);
+            if (m_bipop && lam_large > lam0 && runs_small < runs_large) {
+                regime = "small";
+                auto u = drng(m_e);
+                lam = static_cast<population::size_type>(
+                    std::floor(static_cast<double>(lam0) * std::pow(0.5 * lam_large / lam0, u * u)));
+                lam = fill_pool(pop, std::max(lam, lam0));
+                if (sigma0 > 0.) {
+                    sigma = sigma0 * std::pow(10., -2. * drng(m_e));
+                }
+            } else {
+                // The next IPOP restart doubles the size actually used, rounded up
+                regime = "large";
+                lam_large = fill_pool(pop, 2u * lam_large);
+                lam = lam_large;
+            }
+
+            // 2 - We sample the new population uniformly in the bounds
+            std::vector<vector_double> xs(lam, vector_double(dim));
+            vector_double dvs(lam * dim);
+            for (decltype(lam) i = 0u; i < lam; ++i) {
+                for (decltype(dim) j = 0u; j < dim; ++j) {
+                    xs[i][j] = std::uniform_real_distribution<double>(lb[j], ub[j])(m_e);
+                    dvs[i * dim + j] = xs[i][j];
+                }
+            }
+            auto fs = m_bfe ? (*m_bfe)(prob, dvs) : vector_double{};
+            population newpop{prob, 0u, std::uniform_int_distribution<unsigned>()(m_e)};
+            for (decltype(lam) i = 0u; i < lam; ++i) {
+                if (m_bfe) {
+                    newpop.push_back(xs[i], vector_double{fs[i]});
+                } else {
+                    newpop.push_back(xs[i]);
+                }
+            }
+            pop = newpop;
+        }
+
+        // 3 - We evolve it with a copy of the algorithm, seeded anew
+        auto runs_start = runs_done();
+        algorithm algo = m_algorithm;
+        auto seed = std::uniform_int_distribution<unsigned>()(m_e);
+        visit_es(algo, [&](auto &uda) {
+            uda.set_sigma0(sigma);
+            uda.set_seed(seed);
+        });
+        pop = algo.evolve(pop);
+        auto runs = runs_done() - runs_start;
+        if (regime == "small") {
+            runs_small += runs;
+        } else {
+            runs_large += runs;
+        }
+
+        // 4 - We keep the champion and log the restart
+        auto idx_b = pop.best_idx();
+        if (pop.get_f()[idx_b][0] < best_f) {
+            best_f = pop.get_f()[idx_b][0];
+            best_x = pop.get_x()[idx_b];
+        }
+        if (m_verbosity > 0u) {
+            print(std::setw(9), n, std::setw(9), regime, std::setw(15), runs_done(), std::setw(9), lam,
+                  std::setw(15), sigma, std::setw(15), pop.get_f()[idx_b][0], '\n');
+            m_log.emplace_back(n, runs_done(), static_cast<unsigned>(lam), sigma, pop.get_f()[idx_b][0]);
+        }
+        if (m_logger) {
+            m_logger->save_restart(n, regime, runs_done(), static_cast<unsigned>(lam), sigma, pop.get_f()[idx_b][0]);
+        }
+    }
+    if (m_verbosity > 0u) {
+        if (budget_left()) {
+            std::cout << "Exit condition -- restarts = " << m_max_restarts << std::endl;
+        } else {
+            std::cout << "Exit condition -- budget = " << m_context->get_run_budget() << std::endl;
+        }
+    }
+
+    // The champion of all the restarts takes the place of the worst individual of the last one
+    if (!best_x.empty() && best_f < pop.get_f()[pop.best_idx()][0]) {
+        pop.set_xf(pop.worst_idx(), best_x, vector_double{best_f});
+    }
+    return pop;
+}
+
+/// Population size that fills the scheduler processes
+/**
+ * @param pop the population, whose problem may be a pagmo::mpi_thread.
+ * @param lam the population size wanted.
+ *
+ * @return the smallest size not below \p lam whose tasks are a multiple of the number of processes, or \p lam when
+ * the problem is not a pagmo::mpi_thread.
+ */
+population::size_type restart::fill_pool(const population &pop, population::size_type lam) const
+{
+    const auto *evaluator = pop.get_problem().extract<mpi_thread>();
+    if (!evaluator) {
+        return lam;
+    }
+    auto proc = static_cast<population::size_type>(evaluator->get_proc());
+    auto runs = static_cast<population::size_type>(evaluator->get_runs());
+    auto step = proc / std::gcd(proc, runs);
+    return (lam + step - 1u) / step * step;
+}
+
+/// Sets the seed
+/**
+ * @param seed the seed controlling the algorithm stochastic behaviour
+ */
+void restart::set_seed(unsigned seed)
+{
+    m_e.seed(seed);
+    m_seed = seed;
+}
+
+/// Extra info
+/**
+ * @return a string containing extra info on the algorithm
+ */
+std::string restart::get_extra_info() const
+{
+    std::ostringstream ss;
+    stream(ss, "\tRegimes: ", m_bipop ? "BIPOP" : "IPOP");
+    stream(ss, "\n\tMaximum restarts: ", m_max_restarts);
+    stream(ss, "\n\tVerbosity: ", m_verbosity);
+    stream(ss, "\n\tSeed: ", m_seed);
+    stream(ss, "\n\tRestarted algorithm: ", m_algorithm.get_name());
+    return ss.str();
+}
+
+// Object serialization
+template <typename Archive>
+void restart::serialize(Archive &ar, unsigned)
+{
+    detail::archive(ar, m_algorithm, m_bipop, m_max_restarts, m_e, m_seed, m_verbosity, m_log, m_bfe);
+}
+
+} // namespace pagmo
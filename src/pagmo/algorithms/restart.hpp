@@ -0,0 +1,187 @@
+#ifndef PAGMO_ALGORITHMS_RESTART_HPP
+#define PAGMO_ALGORITHMS_RESTART_HPP
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include <pagmo/algorithm.hpp>
+#include <pagmo/bfe.hpp>
+#include <pagmo/detail/visibility.hpp>
+#include <pagmo/population.hpp>
+#include <pagmo/rng.hpp>
+#include <pagmo/s11n.hpp>
+
+#include "../eval_context.hpp"
+#include "../mylogger.hpp"
+#include "cmaes.hpp"
+#include "lmmaes.hpp"
+#include "snes.hpp"
+#include "xnes.hpp"
+
+namespace pagmo
+{
+/// Calls \p f on the evolution strategy held by \p algo
+/**
+ * The evolution strategies are pagmo::cmaes_t and pagmo::xnes_t in either precision, pagmo::snes and pagmo::lmmaes:
+ * the algorithms that pagmo::restart wraps and whose checkpoints the evolution runs resume. They share the interface
+ * that \p f uses, such as set_sigma0() and set_seed().
+ *
+ * @param algo a pagmo::algorithm, const or not.
+ * @param f a generic callable, called with a reference to the user-defined algorithm of \p algo.
+ *
+ * @return false if \p algo holds none of them, in which case \p f is not called.
+ */
+template <typename Algorithm, typename F>
+bool visit_es(Algorithm &algo, F &&f)
+{
+    auto visit = [&](auto *uda) { return uda != nullptr && (f(*uda), true); };
+    return visit(algo.template extract<cmaes>()) || visit(algo.template extract<cmaes_t<float>>())
+           || visit(algo.template extract<xnes>()) || visit(algo.template extract<xnes_t<float>>())
+           || visit(algo.template extract<snes>()) || visit(algo.template extract<lmmaes>());
+}
+
+/// IPOP and BIPOP restarts of an evolution strategy
+/**
+ * Wraps pagmo::cmaes_t, pagmo::xnes_t (in either precision), pagmo::snes or pagmo::lmmaes so that, when their
+ * tolerances stop them, the evolution starts again from a new random population until the run budget of the evaluation
+ * context is spent.
+ *
+ * - IPOP: every restart doubles the population size.
+ * - BIPOP: the restarts alternate between the IPOP regime and a small regime whose population size is drawn between
+ *   the initial one and half the last IPOP one, and whose initial step-size is divided by up to 100. A small restart
+ *   is made whenever the small regime spent fewer runs than the IPOP one.
+ *
+ * When the problem is a pagmo::mpi_thread, the population sizes are rounded up so that a generation gives the same
+ * number of tasks to every scheduler process. The population returned holds the champion of all the restarts.
+ */
+class PAGMO_DLL_PUBLIC restart
+{
+public:
+    /// Single data line for the algorithm's log.
+    /**
+     * A log data line is a tuple consisting of:
+     * - the restart number, 0 for the initial run,
+     * - the number of runs done at its end,
+     * - the population size,
+     * - the initial step-size,
+     * - the best fitness it found.
+     */
+    typedef std::tuple<unsigned, unsigned long long, unsigned, double, double> log_line_type;
+
+    /// Log type.
+    typedef std::vector<log_line_type> log_type;
+
+    /// Constructor.
+    /**
+     * @param algo the restarted algorithm, a pagmo::cmaes, a pagmo::xnes, a pagmo::snes or a pagmo::lmmaes without
+     * memory.
+     * @param bipop when true the BIPOP regimes are used, otherwise IPOP.
+     * @param max_restarts maximum number of restarts.
+     * @param log logger of the restarts.
+     * @param seed seed used by the internal random number generator (default is random).
+     *
+     * @throws std::invalid_argument if \p algo is not a pagmo::cmaes, a pagmo::xnes, a pagmo::snes or a pagmo::lmmaes.
+     */
+    restart(const algorithm &algo = algorithm{cmaes{}}, bool bipop = false, unsigned max_restarts = 100u,
+            logger *log = nullptr, unsigned seed = pagmo::random_device::next());
+
+    // Algorithm evolve method
+    population evolve(population) const;
+
+    // Sets the seed
+    void set_seed(unsigned);
+
+    /// Gets the seed
+    unsigned get_seed() const
+    {
+        return m_seed;
+    }
+
+    /// Sets the algorithm verbosity
+    /**
+     * - 0: no verbosity
+     * - >0: will print one line per restart, and sets the verbosity of the restarted algorithm.
+     *
+     * @param level verbosity level
+     */
+    void set_verbosity(unsigned level)
+    {
+        m_verbosity = level;
+        m_algorithm.set_verbosity(level);
+    }
+
+    /// Gets the verbosity level
+    unsigned get_verbosity() const
+    {
+        return m_verbosity;
+    }
+
+    /// Sets the bfe
+    /**
+     * The new populations of the restarts are evaluated with it.
+     *
+     * @param b the batch evaluator.
+     */
+    void set_bfe(const bfe &b)
+    {
+        m_bfe = b;
+    }
+
+    /// Sets the evaluation context
+    /**
+     * When a context is set, the restarts go on until its run budget is spent, and the BIPOP regimes are compared on
+     * its runs. It must also be the context of the restarted algorithm.
+     *
+     * @param context evaluation context shared with the problem, or nullptr.
+     */
+    void set_eval_context(eval_context *context)
+    {
+        m_context = context;
+    }
+
+    /// Algorithm name
+    std::string get_name() const
+    {
+        return (m_bipop ? "BIPOP restarts of " : "IPOP restarts of ") + m_algorithm.get_name();
+    }
+
+    // Extra info
+    std::string get_extra_info() const;
+
+    /// Get log
+    const log_type &get_log() const
+    {
+        return m_log;
+    }
+
+private:
+    // Object serialization
+    friend class boost::serialization::access;
+    template <typename Archive>
+    void serialize(Archive &, unsigned);
+
+    population::size_type fill_pool(const population &, population::size_type) const;
+
+    // Data members
+    algorithm m_algorithm;
+    bool m_bipop;
+    unsigned m_max_restarts;
+    logger *m_logger;
+    eval_context *m_context;
+
+    // "Common" data members
+    mutable detail::random_engine_type m_e;
+    unsigned m_seed;
+    unsigned m_verbosity;
+    mutable log_type m_log;
+    boost::optional<bfe> m_bfe;
+};
+
+} // namespace pagmo
+
+PAGMO_S11N_ALGORITHM_EXPORT_KEY(pagmo::restart)
+
+#endif
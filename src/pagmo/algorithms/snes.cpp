@@ -0,0 +1,352 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pagmo/algorithm.hpp>
+
+#include "nes.hpp"
+#include "snes.hpp"
+
+#include <pagmo/detail/eigen.hpp>
+#include <pagmo/detail/eigen_s11n.hpp>
+#include <pagmo/exceptions.hpp>
+#include <pagmo/io.hpp>
+#include <pagmo/population.hpp>
+#include <pagmo/s11n.hpp>
+#include <pagmo/types.hpp>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+
+// NOTE: apparently this must be included *after*
+// the other serialization headers.
+#include <boost/serialization/optional.hpp>
+
+namespace pagmo
+{
+
+snes::snes(unsigned gen, double eta_mu, double eta_sigma, double sigma0, double ftol, double xtol, bool memory,
+           bool force_bounds, logger *log, unsigned seed)
+    : m_gen(gen), m_eta_mu(eta_mu), m_eta_sigma(eta_sigma), m_sigma0(sigma0), m_ftol(ftol), m_xtol(xtol),
+      m_memory(memory), m_force_bounds(force_bounds), m_logger(log), m_context(nullptr), m_checkpoint(nullptr),
+      m_gen_done(0u), m_e(seed), m_seed(seed), m_verbosity(0u), m_log()
+{
+    if (((eta_mu <= 0.) || (eta_mu > 1.)) && !(eta_mu == -1)) {
+        pagmo_throw(std::invalid_argument,
+                    "eta_mu must be in ]0,1] or -1 if its value has to be initialized automatically, a value of "
+                        + std::to_string(eta_mu) + " was detected");
+    }
+    if (((eta_sigma <= 0.) || (eta_sigma > 1.)) && !(eta_sigma == -1)) {
+        pagmo_throw(std::invalid_argument,
+                    "eta_sigma needs to be in ]0,1] or -1 if its value has to be initialized automatically, a value of "
+                        + std::to_string(eta_sigma) + " was detected");
+    }
+    if (((sigma0 <= 0.) || (sigma0 > 1.)) && !(sigma0 == -1)) {
+        pagmo_throw(std::invalid_argument,
+                    "sigma0 needs to be in ]0,1] or -1 if its value has to be initialized automatically, a value of "
+                        + std::to_string(sigma0) + " was detected");
+    }
+    // Initialize explicitly the algorithm memory
+    sigma = m_sigma0;
+    mean = Eigen::VectorXd::Zero(1);
+    s = Eigen::VectorXd::Ones(1);
+}
+
+/// Algorithm evolve method
+/**
+ *
+ * Evolves the population for a maximum number of generations, until one of
+ * tolerances set on the population flatness (x_tol, f_tol) are met.
+ *
+ * @param pop population to be evolved
+ * @return evolved population
+ * @throws std::invalid_argument if the problem is multi-objective or constrained
+ * @throws std::invalid_argument if the problem is unbounded
+ * @throws std::invalid_argument if the population size is not at least 4
+ */
+population snes::evolve(population pop) const
+{
+    // We store some useful variables
+    const auto &prob = pop.get_problem(); // This is a const reference, so using set_seed for example will not be
+                                          // allowed.
+    auto dim = prob.get_nx();
+    const auto bounds = prob.get_bounds();
+    const auto &lb = bounds.first;
+    const auto &ub = bounds.second;
+    auto lam = pop.size();
+    auto prob_f_dimension = prob.get_nf();
+    auto fevals0 = prob.get_fevals(); // discount for the already made fevals
+    auto count = 1u;                  // regulates the screen output
+
+    // PREAMBLE--------------------------------------------------
+    // Checks on the problem type
+    if (prob.get_nc() != 0u) {
+        pagmo_throw(std::invalid_argument, "Non linear constraints detected in " + prob.get_name() + " instance. "
+                                               + get_name() + " cannot deal with them");
+    }
+    if (prob_f_dimension != 1u) {
+        pagmo_throw(std::invalid_argument, "Multiple objectives detected in " + prob.get_name() + " instance. "
+                                               + get_name() + " cannot deal with them");
+    }
+    if (lam < 4u) {
+        pagmo_throw(std::invalid_argument, get_name() + " needs at least 4 individuals in the population, "
+                                               + std::to_string(lam) + " detected");
+    }
+    for (auto num : lb) {
+        if (!std::isfinite(num)) {
+            pagmo_throw(std::invalid_argument, "A " + std::to_string(num) + " is detected in the lower bounds, "
+                                                   + get_name() + " cannot deal with it.");
+        }
+    }
+    for (auto num : ub) {
+        if (!std::isfinite(num)) {
+            pagmo_throw(std::invalid_argument, "A " + std::to_string(num) + " is detected in the upper bounds, "
+                                                   + get_name() + " cannot deal with it.");
+        }
+    }
+    // Get out if there is nothing to do.
+    if (m_gen == 0u) {
+        return pop;
+    }
+    // -----------------------------------------------------------
+
+    // No throws, all valid: we clear the logs
+    m_log.clear();
+
+    // -------------------------------------------------------//
+    // HERE WE PREPARE AND DEFINE VARIOUS PARAMETERS          //
+    // -------------------------------------------------------//
+    // Initializing the random number generators
+    std::normal_distribution<double> normally_distributed_number(0., 1.);
+    // Initialize default values for the learning rates
+    double dim_d = static_cast<double>(dim);
+
+    double eta_mu(m_eta_mu), eta_sigma(m_eta_sigma);
+    if (eta_mu == -1) {
+        eta_mu = 1.;
+    }
+    if (eta_sigma == -1) {
+        eta_sigma = (3. + std::log(dim_d)) / (5. * std::sqrt(dim_d));
+    }
+    // Initialize the utility function u
+    std::vector<double> u = nes::utilities(lam);
+    // If m_memory is false we redefine mutable members erasing the memory of past calls, unless the algorithm was
+    // restored from a checkpoint. This is also done if the problem dimension has changed
+    if ((mean.size() != _(dim)) || (m_memory == false && m_gen_done == 0u)) {
+        if (m_sigma0 == -1) {
+            sigma = 0.5;
+        } else {
+            sigma = m_sigma0;
+        }
+        // The initial step-sizes define the search width in all directions: by default we set them to be sigma
+        // times the width of the box bounds or 1e-6 if too small.
+        s.resize(_(dim));
+        for (decltype(dim) j = 0u; j < dim; ++j) {
+            s(_(j)) = std::max((ub[j] - lb[j]), 1e-6) * sigma;
+        }
+        mean.resize(_(dim));
+        auto idx_b = pop.best_idx();
+        for (decltype(dim) i = 0u; i < dim; ++i) {
+            mean(_(i)) = pop.get_x()[idx_b][i];
+        }
+        m_gen_done = 0u;
+    }
+    auto first_gen = m_gen_done + 1u;
+    m_gen_done = 0u;
+    // This will hold in the eigen data structure the sampled population
+    Eigen::VectorXd tmp = Eigen::VectorXd::Zero(_(dim));
+    auto z = std::vector<Eigen::VectorXd>(lam, tmp);
+    auto x = std::vector<Eigen::VectorXd>(lam, tmp);
+
+    if (m_verbosity > 0u) {
+        std::cout << "SNES 4 PaGMO: " << std::endl;
+        print("eta_mu: ", eta_mu, " - eta_sigma: ", eta_sigma, " - sigma0: ", sigma, "\n");
+        print("utilities: ", u, "\n");
+
+        if (m_logger && m_logger->is_genome() && first_gen == 1u) {
+            m_logger->save_hist_score(0, &pop);
+        }
+    }
+
+    // ----------------------------------------------//
+    // HERE WE START THE JUICE OF THE ALGORITHM      //
+    // ----------------------------------------------//
+
+    for (decltype(m_gen) gen = first_gen; gen <= m_gen; ++gen) {
+        // Exit condition on the run budget
+        if (m_context && m_context->budget_exhausted()) {
+            if (m_verbosity > 0u) {
+                std::cout << "Exit condition -- budget = " << m_context->get_run_budget() << std::endl;
+            }
+            return pop;
+        }
+        // 0 -If the problem is stochastic change seed first
+        if (prob.is_stochastic()) {
+            // change the problem seed. This is done via the population_set_seed method as prob.set_seed
+            // is forbidden being prob a const ref.
+            pop.get_problem().set_seed(std::uniform_int_distribution<unsigned>()(m_e));
+        }
+        // 1 - We generate lam new individuals using the current probability distribution
+        // In the seeded sampling mode the individuals are drawn by sample_candidate() from one seed each, the
+        // distribution being diagonal: only the step-sizes are sent with it.
+        sampling_batch *batch = nes::seeded_batch(m_context, mean, lb, ub, m_force_bounds, lam);
+        if (batch) {
+            batch->state.diagonal = true;
+            batch->state.scale = s;
+        }
+        for (decltype(lam) i = 0u; i < lam; ++i) {
+            if (batch) {
+                batch->seeds[i] = std::uniform_int_distribution<unsigned>()(m_e);
+                sample_candidate(batch->state, batch->seeds[i], z[i], x[i]);
+            } else {
+                // 1a - we create a randomly normal distributed vector
+                for (decltype(dim) j = 0u; j < dim; ++j) {
+                    z[i](_(j)) = normally_distributed_number(m_e);
+                }
+                // 1b - and store its scaled value in the new chromosomes
+                x[i] = mean + s.cwiseProduct(z[i]);
+            }
+        }
+        nes::evaluate(pop, m_bfe, x, m_force_bounds && !batch);
+
+        // 2 - Check the exit conditions and logs
+        // Exit condition on xtol
+        {
+            if (s.cwiseProduct(z[0]).norm() < m_xtol) {
+                if (m_verbosity > 0u) {
+                    std::cout << "Exit condition -- xtol < " << m_xtol << std::endl;
+                }
+                return pop;
+            }
+            // Exit condition on ftol
+            auto idx_b = pop.best_idx();
+            auto idx_w = pop.worst_idx();
+            double delta_f = std::abs(pop.get_f()[idx_b][0] - pop.get_f()[idx_w][0]);
+            if (delta_f < m_ftol) {
+                if (m_verbosity) {
+                    std::cout << "Exit condition -- ftol < " << m_ftol << std::endl;
+                }
+                return pop;
+            }
+        }
+
+        // 2bis - Logs and prints (verbosity modes > 1: a line is added every m_verbosity generations)
+        if (m_verbosity > 0u) {
+            // Every m_verbosity generations print a log line
+            if (gen % m_verbosity == 1u || m_verbosity == 1u) {
+                // The population flatness in chromosome
+                double dx = s.cwiseProduct(z[0]).norm();
+                nes::print_generation(m_log, count, gen, prob.get_fevals() - fevals0, pop, dx, sigma);
+                // Save genome to file
+                nes::log_generation(m_logger, m_context, gen, mean, pop);
+            }
+        }
+
+        // 3 - We sort the population
+        std::vector<vector_double::size_type> s_idx(lam);
+        std::iota(s_idx.begin(), s_idx.end(), vector_double::size_type(0u));
+        std::sort(s_idx.begin(), s_idx.end(), [&pop](vector_double::size_type a, vector_double::size_type b) {
+            return pop.get_f()[a][0] < pop.get_f()[b][0];
+        });
+        // 4 - We update the mean and the step-sizes following the snes rules: the natural gradients are those of xnes
+        // restricted to the diagonal, so that the update costs O(lam dim) and needs no matrix exponential
+        Eigen::VectorXd d_center = u[0] * z[s_idx[0]];
+        Eigen::VectorXd s_grad = u[0] * (z[s_idx[0]].array().square() - 1.).matrix();
+        for (decltype(u.size()) i = 1u; i < u.size(); ++i) {
+            d_center += u[i] * z[s_idx[i]];
+            s_grad += u[i] * (z[s_idx[i]].array().square() - 1.).matrix();
+        }
+        mean = mean + eta_mu * s.cwiseProduct(d_center);
+        s = s.cwiseProduct((eta_sigma / 2. * s_grad).array().exp().matrix());
+        sigma = sigma * std::exp(eta_sigma / 2. * s_grad.mean()); // used only for cmaes comparisons
+
+        // 5 - Save a checkpoint, from which evolve() resumes after this generation
+        if (m_checkpoint && m_checkpoint->due(gen)) {
+            m_gen_done = gen;
+            m_checkpoint->save(*this, gen, pop);
+            m_gen_done = 0u;
+        }
+    }
+
+    if (m_verbosity) {
+        std::cout << "Exit condition -- generations = " << m_gen << std::endl;
+    }
+    return pop;
+}
+
+/// Sets the seed
+/**
+ * @param seed the seed controlling the algorithm stochastic behaviour
+ */
+void snes::set_seed(unsigned seed)
+{
+    m_e.seed(seed);
+    m_seed = seed;
+}
+
+/// Sets the batch function evaluation scheme
+/**
+ * @param b batch function evaluation object
+ */
+void snes::set_bfe(const bfe &b)
+{
+    m_bfe = b;
+}
+
+/// Extra info
+/**
+ * One of the optional methods of any user-defined algorithm (UDA).
+ *
+ * @return a string containing extra info on the algorithm
+ */
+std::string snes::get_extra_info() const
+{
+    std::ostringstream ss;
+    stream(ss, "\tGenerations: ", m_gen);
+    stream(ss, "\n\teta_mu: ");
+    if (m_eta_mu == -1) {
+        stream(ss, "auto");
+    } else {
+        stream(ss, m_eta_mu);
+    }
+    stream(ss, "\n\teta_sigma: ");
+    if (m_eta_sigma == -1) {
+        stream(ss, "auto");
+    } else {
+        stream(ss, m_eta_sigma);
+    }
+    stream(ss, "\n\tsigma0: ");
+    if (m_sigma0 == -1) {
+        stream(ss, "auto");
+    } else {
+        stream(ss, m_sigma0);
+    }
+    stream(ss, "\n\tStopping xtol: ", m_xtol);
+    stream(ss, "\n\tStopping ftol: ", m_ftol);
+    stream(ss, "\n\tMemory: ", m_memory);
+    stream(ss, "\n\tForce bounds: ", m_force_bounds);
+    stream(ss, "\n\tVerbosity: ", m_verbosity);
+    stream(ss, "\n\tSeed: ", m_seed);
+    return ss.str();
+}
+
+// Object serialization
+template <typename Archive>
+void snes::serialize(Archive &ar, unsigned)
+{
+    detail::archive(ar, m_gen, m_eta_mu, m_eta_sigma, m_sigma0, m_ftol, m_xtol, m_memory, m_force_bounds, sigma, mean,
+                    s, m_e, m_seed, m_verbosity, m_log, m_bfe, m_gen_done);
+}
+
+// The checkpoints of the evolution runs archive the algorithm in binary form (see checkpoint.hpp)
+template void snes::serialize(boost::archive::binary_oarchive &, unsigned);
+template void snes::serialize(boost::archive::binary_iarchive &, unsigned);
+
+} // namespace pagmo
@@ -0,0 +1,229 @@
+#ifndef PAGMO_ALGORITHMS_SNES_HPP
+#define PAGMO_ALGORITHMS_SNES_HPP
+
+#include <pagmo/config.hpp>
+
+#if defined(PAGMO_WITH_EIGEN3)
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include <pagmo/algorithm.hpp>
+#include <pagmo/bfe.hpp>
+#include <pagmo/detail/eigen.hpp>
+#include <pagmo/detail/visibility.hpp>
+#include <pagmo/population.hpp>
+#include <pagmo/rng.hpp>
+#include <pagmo/s11n.hpp>
+
+#include "../checkpoint.hpp"
+#include "../eval_context.hpp"
+#include "../mylogger.hpp"
+
+namespace pagmo
+{
+/// Separable Natural Evolution Strategies
+/**
+ * SNES is the member of the Natural Evolution Strategies family, like pagmo::xnes, whose search distribution has a
+ * diagonal covariance: it follows the natural gradient of the expected fitness with respect to the mean and to one
+ * step-size per coordinate. A generation then costs O(lambda N) instead of the O(N^3) matrix exponential of xNES, and
+ * the state O(N) memory, which suits large networks whose weights interact weakly. The fitness shaping utilities and
+ * the logs are those of pagmo::xnes.
+ *
+ * As in pagmo::xnes, the initial step-sizes are sigma0 times the widths of the bounds.
+ *
+ * \verbatim embed:rst:leading-asterisk
+ * .. seealso::
+ *
+ *    Schaul, T., Glasmachers, T., & Schmidhuber, J. (2011, July). High dimensions and heavy tails for natural
+ *    evolution strategies. In Proceedings of the 13th annual conference on Genetic and evolutionary computation (pp.
+ *    845-852). ACM.
+ * \endverbatim
+ */
+class PAGMO_DLL_PUBLIC snes
+{
+public:
+    /// Single data line for the algorithm's log.
+    /**
+     * A log data line is a tuple consisting of:
+     * - the generation number,
+     * - the number of function evaluations,
+     * - the best fitness in the population,
+     * - the norm of the first mutant vector,
+     * - the population flatness evaluated as the distance between the fitness of the best and of the worst individual,
+     * - sigma, the initial step-size scaled by the geometric mean of the updates of the step-sizes.
+     */
+    typedef std::tuple<unsigned, unsigned long long, double, double, double, double> log_line_type;
+
+    /// Log type.
+    typedef std::vector<log_line_type> log_type;
+
+    /// Constructor.
+    /**
+     * @param gen number of generations.
+     * @param eta_mu learning rate for mean update (if -1 will be automatically selected to be 1)
+     * @param eta_sigma learning rate for the step-sizes update (if -1 will be automatically selected)
+     * @param sigma0 the initial search width will be sigma0 * (ub - lb) (if -1 will be selected to be 0.5)
+     * @param ftol stopping criteria on the f tolerance (default is 1e-6)
+     * @param xtol stopping criteria on the x tolerance (default is 1e-6)
+     * @param memory when true the distribution parameters are not reset between successive calls to the evolve method
+     * @param force_bounds when true the box bounds are enforced.
+     * @param log logger of the scores and of the means.
+     * @param seed seed used by the internal random number generator (default is random)
+     *
+     * @throws std::invalid_argument if eta_mu, eta_sigma and sigma0 are not in ]0, 1] or -1
+     */
+    snes(unsigned gen = 1, double eta_mu = -1, double eta_sigma = -1, double sigma0 = -1, double ftol = 1e-6,
+         double xtol = 1e-6, bool memory = false, bool force_bounds = false, logger *log = nullptr,
+         unsigned seed = pagmo::random_device::next());
+
+    // Algorithm evolve method
+    population evolve(population) const;
+
+    // Sets the seed
+    void set_seed(unsigned);
+
+    /// Gets the seed
+    unsigned get_seed() const
+    {
+        return m_seed;
+    }
+
+    /// Sets the algorithm verbosity
+    /**
+     * - 0: no verbosity
+     * - >0: will print and log one line each \p level generations, with the columns of pagmo::xnes.
+     *
+     * @param level verbosity level
+     */
+    void set_verbosity(unsigned level)
+    {
+        m_verbosity = level;
+    }
+
+    /// Gets the verbosity level
+    unsigned get_verbosity() const
+    {
+        return m_verbosity;
+    }
+
+    /// Gets the generations
+    unsigned get_gen() const
+    {
+        return m_gen;
+    }
+
+    /// Sets the initial step-size
+    /**
+     * Used by the next call to evolve() that resets the memory of the algorithm.
+     *
+     * @param sigma0 initial step-size, or -1 for the automatic value.
+     */
+    void set_sigma0(double sigma0)
+    {
+        m_sigma0 = sigma0;
+    }
+
+    /// Gets the initial step-size
+    double get_sigma0() const
+    {
+        return m_sigma0;
+    }
+
+    /// Sets the bfe
+    void set_bfe(const bfe &b);
+
+    /// Sets the evaluation context
+    /**
+     * When a context is set, evolve() stops as soon as its run budget is spent.
+     *
+     * @param context evaluation context shared with the problem, or nullptr.
+     */
+    void set_eval_context(eval_context *context)
+    {
+        m_context = context;
+    }
+
+    /// Sets the checkpoints
+    /**
+     * When set, the state of the algorithm and the population are saved at the end of every generation after which a
+     * checkpoint is due, and an algorithm restored from a checkpoint resumes after its last generation (see
+     * pagmo::checkpoint).
+     *
+     * @param cp checkpoints of the run, or nullptr.
+     */
+    void set_checkpoint(checkpoint *cp)
+    {
+        m_checkpoint = cp;
+    }
+
+    /// Algorithm name
+    std::string get_name() const
+    {
+        return "SNES: Separable Natural Evolution Strategies";
+    }
+
+    // Extra info
+    std::string get_extra_info() const;
+
+    /// Get log
+    const log_type &get_log() const
+    {
+        return m_log;
+    }
+
+private:
+    // Object serialization
+    friend class boost::serialization::access;
+    template <typename Archive>
+    void serialize(Archive &, unsigned);
+
+    template <typename I>
+    static Eigen::DenseIndex _(I n)
+    {
+        return static_cast<Eigen::DenseIndex>(n);
+    }
+
+    // "Real" data members
+    unsigned m_gen;
+    double m_eta_mu;
+    double m_eta_sigma;
+    double m_sigma0;
+    double m_ftol;
+    double m_xtol;
+    bool m_memory;
+    bool m_force_bounds;
+    logger *m_logger;
+    eval_context *m_context;
+    checkpoint *m_checkpoint;
+
+    // "Memory" data members (these are adapted during each evolve call and may be remembered if m_memory is true)
+    mutable double sigma;
+    mutable Eigen::VectorXd mean;
+    // Step-size of each coordinate
+    mutable Eigen::VectorXd s;
+    // Generations done when checkpointed: evolve() resumes after them
+    mutable unsigned m_gen_done;
+
+    // "Common" data members
+    mutable detail::random_engine_type m_e;
+    unsigned m_seed;
+    unsigned m_verbosity;
+    mutable log_type m_log;
+    boost::optional<bfe> m_bfe;
+};
+
+} // namespace pagmo
+
+PAGMO_S11N_ALGORITHM_EXPORT_KEY(pagmo::snes)
+
+#else // PAGMO_WITH_EIGEN3
+
+#error The snes.hpp header was included, but pagmo was not compiled with eigen3 support
+
+#endif // PAGMO_WITH_EIGEN3
+
+#endif
@@ -39,6 +39,8 @@ see https://www.gnu.org/licenses/. */
 
 #include <pagmo/algorithm.hpp>
 
+#include "fixed_dim.hpp"
+#include "nes.hpp"
 #include "xnes.hpp"
 
 #include <pagmo/detail/eigen.hpp>
@@ -49,15 +51,58 @@ see https://www.gnu.org/licenses/. */
 #include <pagmo/s11n.hpp>
 #include <pagmo/types.hpp>
 
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+
+// NOTE: apparently this must be included *after*
+// the other serialization headers.
+#include <boost/serialization/optional.hpp>
 
 namespace pagmo 
 {
 
-xnes::xnes(unsigned gen, double eta_mu, double eta_sigma, double eta_b, double sigma0, double ftol,
-           double xtol, bool memory, bool force_bounds, logger* log, unsigned seed)
+namespace
+{
+
+// A * exp(alpha I + Z diag(w) Z^T), for the update of A
+// The exponent is symmetric, so its exponential is taken on its eigenvalues. When the population is smaller than the
+// dimension, with the thin QR decomposition Z = Q R, Z diag(w) Z^T = Q M Q^T where M = R diag(w) R^T is of the size of
+// the population, and exp(Q M Q^T) = I + Q (exp(M) - I) Q^T: this is exact and costs O(dim^2 lam) instead of the
+// O(dim^3) of the exponential of a dim x dim matrix. It is computed in the precision of A.
+template <typename Matrix>
+Matrix multiply_exp(const Matrix &A, double alpha, const Eigen::MatrixXd &Zd, const Eigen::VectorXd &wd)
+{
+    using Scalar = typename Matrix::Scalar;
+    const Matrix Z = Zd.cast<Scalar>();
+    const Eigen::Matrix<Scalar, Eigen::Dynamic, 1> w = wd.cast<Scalar>();
+    if (Z.cols() >= Z.rows()) {
+        Matrix X = Z * w.asDiagonal() * Z.transpose();
+        X.diagonal().array() += static_cast<Scalar>(alpha);
+        Eigen::SelfAdjointEigenSolver<Matrix> es(X);
+        Matrix AV = A * es.eigenvectors();
+        return AV * es.eigenvalues().array().exp().matrix().asDiagonal() * es.eigenvectors().transpose();
+    }
+    auto k = Z.cols();
+    Eigen::HouseholderQR<Matrix> qr(Z);
+    Matrix Q = qr.householderQ() * Matrix::Identity(Z.rows(), k);
+    Matrix R = qr.matrixQR().topRows(k).template triangularView<Eigen::Upper>();
+    Matrix M = R * w.asDiagonal() * R.transpose();
+    Eigen::SelfAdjointEigenSolver<Matrix> es(M);
+    Matrix expM_I = es.eigenvectors() * (es.eigenvalues().array().exp() - Scalar(1)).matrix().asDiagonal()
+                    * es.eigenvectors().transpose();
+    Matrix AQ = A * Q;
+    return static_cast<Scalar>(std::exp(alpha)) * (A + AQ * expM_I * Q.transpose());
+}
+
+} // namespace
+
+template <typename Scalar>
+xnes_t<Scalar>::xnes_t(unsigned gen, double eta_mu, double eta_sigma, double eta_b, double sigma0, double ftol,
+                       double xtol, bool memory, bool force_bounds, logger *log, unsigned seed)
     : m_gen(gen), m_eta_mu(eta_mu), m_eta_sigma(eta_sigma), m_eta_b(eta_b), m_sigma0(sigma0),
       m_ftol(ftol), m_xtol(xtol), m_memory(memory), m_force_bounds(force_bounds), m_logger(log),
-      m_e(seed), m_seed(seed), m_verbosity(0u), m_log() {
+      m_context(nullptr), m_checkpoint(nullptr), m_gen_done(0u), m_e(seed), m_seed(seed), m_verbosity(0u),
+      m_log() {
     if (((eta_mu <= 0.) || (eta_mu > 1.)) && !(eta_mu == -1)) {
         pagmo_throw(std::invalid_argument,
                     "eta_mu must be in ]0,1] or -1 if its value has to be initialized automatically, a value of "
@@ -81,7 +126,7 @@ xnes::xnes(unsigned gen, double eta_mu, double eta_sigma, double eta_b, double s
     // Initialize explicitly the algorithm memory
     sigma = m_sigma0;
     mean = Eigen::VectorXd::Zero(1);
-    A = Eigen::MatrixXd::Identity(1, 1);
+    A = matrix_type::Identity(1, 1);
 }
 
 /// Algorithm evolve method
@@ -96,7 +141,8 @@ xnes::xnes(unsigned gen, double eta_mu, double eta_sigma, double eta_b, double s
  * @throws std::invalid_argument if the problem is unbounded
  * @throws std::invalid_argument if the population size is not at least 4
  */
-population xnes::evolve(population pop) const
+template <typename Scalar>
+population xnes_t<Scalar>::evolve(population pop) const
 {
     // We store some useful variables
     const auto &prob = pop.get_problem(); // This is a const reference, so using set_seed for example will not be
@@ -153,7 +199,6 @@ population xnes::evolve(population pop) const
     std::normal_distribution<double> normally_distributed_number(0., 1.);
     // Initialize default values for the learning rates
     double dim_d = static_cast<double>(dim);
-    double lam_d = static_cast<double>(lam);
 
     double eta_mu(m_eta_mu), eta_sigma(m_eta_sigma), eta_b(m_eta_b);
     if (eta_mu == -1) {
@@ -167,50 +212,44 @@ population xnes::evolve(population pop) const
         eta_b = common_default;
     }
     // Initialize the utility function u
-    std::vector<double> u(lam);
-    for (decltype(u.size()) i = 0u; i < u.size(); ++i) {
-        u[i] = std::max(0., std::log(lam_d / 2. + 1.) - std::log(i + 1));
-    }
-    double sum = 0.;
-    for (decltype(u.size()) i = 0u; i < u.size(); ++i) {
-        sum += u[i];
-    }
-    for (decltype(u.size()) i = 0u; i < u.size(); ++i) {
-        u[i] = u[i] / sum - 1. / lam_d; // Give an option to turn off the uniform baseline (i.e. -1/lam_d) ?
-    }
-    // If m_memory is false we redefine mutable members erasing the memory of past calls.
-    // This is also done if the problem dimension has changed
-    if ((mean.size() != _(dim)) || (m_memory == false)) {
+    std::vector<double> u = nes::utilities(lam);
+    Eigen::Map<const Eigen::VectorXd> u_vec(u.data(), _(lam));
+    // If m_memory is false we redefine mutable members erasing the memory of past calls, unless the algorithm was
+    // restored from a checkpoint. This is also done if the problem dimension has changed
+    if ((mean.size() != _(dim)) || (m_memory == false && m_gen_done == 0u)) {
         if (m_sigma0 == -1) {
             sigma = 0.5;
         } else {
             sigma = m_sigma0;
         }
-        A = Eigen::MatrixXd::Identity(_(dim), _(dim));
+        A = matrix_type::Identity(_(dim), _(dim));
         // The diagonal of the initial covariance matrix A defines the search width in all directions.
         // By default we set this to be sigma times the width of the box bounds or 1e-6 if too small.
         for (decltype(dim) j = 0u; j < dim; ++j) {
-            A(_(j), _(j)) = std::max((ub[j] - lb[j]), 1e-6) * sigma;
+            A(_(j), _(j)) = static_cast<Scalar>(std::max((ub[j] - lb[j]), 1e-6) * sigma);
         }
         mean.resize(_(dim));
         auto idx_b = pop.best_idx();
         for (decltype(dim) i = 0u; i < dim; ++i) {
             mean(_(i)) = pop.get_x()[idx_b][i];
         }
+        m_gen_done = 0u;
     }
+    auto first_gen = m_gen_done + 1u;
+    m_gen_done = 0u;
     // This will hold in the eigen data structure the sampled population
     Eigen::VectorXd tmp = Eigen::VectorXd::Zero(_(dim));
     auto z = std::vector<Eigen::VectorXd>(lam, tmp);
     auto x = std::vector<Eigen::VectorXd>(lam, tmp);
-    // Temporary container
-    vector_double dumb(dim, 0.);
+    // The normal vectors sorted by fitness, one per column
+    Eigen::MatrixXd Z(_(dim), _(lam));
 
     if (m_verbosity > 0u) {
         std::cout << "xNES 4 PaGMO: " << std::endl;
         print("eta_mu: ", eta_mu, " - eta_sigma: ", eta_sigma, " - eta_b: ", eta_b, " - sigma0: ", sigma, "\n");
         print("utilities: ", u, "\n");
 
-        if (m_logger->is_genome()) {
+        if (m_logger && m_logger->is_genome() && first_gen == 1u) {
             m_logger->save_hist_score(0, &pop);
         }
     }
@@ -219,7 +258,14 @@ population xnes::evolve(population pop) const
     // HERE WE START THE JUICE OF THE ALGORITHM      //
     // ----------------------------------------------//
     
-    for (decltype(m_gen) gen = 1u; gen <= m_gen; ++gen) {
+    for (decltype(m_gen) gen = first_gen; gen <= m_gen; ++gen) {
+        // Exit condition on the run budget
+        if (m_context && m_context->budget_exhausted()) {
+            if (m_verbosity > 0u) {
+                std::cout << "Exit condition -- budget = " << m_context->get_run_budget() << std::endl;
+            }
+            return pop;
+        }
         // 0 -If the problem is stochastic change seed first
         if (prob.is_stochastic()) {
             // change the problem seed. This is done via the population_set_seed method as prob.set_seed
@@ -227,34 +273,40 @@ population xnes::evolve(population pop) const
             pop.get_problem().set_seed(std::uniform_int_distribution<unsigned>()(m_e));
         }
         // 1 - We generate lam new individuals using the current probability distribution
+        // In the seeded sampling mode the individuals are drawn by sample_candidate() from one seed each, and the
+        // distribution and seeds are left to the evaluator, which can send them instead of the individuals.
+        sampling_batch *batch = nes::seeded_batch(m_context, mean, lb, ub, m_force_bounds, lam);
+        if (batch) {
+            batch->state.diagonal = false;
+            batch->state.transform = A.template cast<double>();
+        }
         for (decltype(lam) i = 0u; i < lam; ++i) {
-            // 1a - we create a randomly normal distributed vector
-            for (decltype(dim) j = 0u; j < dim; ++j) {
-                z[i](_(j)) = normally_distributed_number(m_e);
-            }
-            // 1b - and store its transformed value in the new chromosomes
-            x[i] = mean + A * z[i];
-            if (m_force_bounds) {
-                // We fix the bounds. Note that this screws up the whole covariance matrix machinery and worsen
-                // performances considerably.
+            if (batch) {
+                batch->seeds[i] = std::uniform_int_distribution<unsigned>()(m_e);
+                sample_candidate(batch->state, batch->seeds[i], z[i], x[i]);
+            } else {
+                // 1a - we create a randomly normal distributed vector
                 for (decltype(dim) j = 0u; j < dim; ++j) {
-                    if (x[i](_(j)) < lb[j]) {
-                        x[i](_(j)) = lb[j];
-                    } else if (x[i](_(j)) > ub[j]) {
-                        x[i](_(j)) = ub[j];
-                    }
+                    z[i](_(j)) = normally_distributed_number(m_e);
                 }
+                // 1b - and store its transformed value in the new chromosomes (see fixed_dim.hpp), the product being
+                // computed in the precision of A
+                detail::with_fixed_dim(dim, [&](auto fixed) {
+                    constexpr int Dim = decltype(fixed)::value;
+                    Eigen::Map<const detail::fixed_matrix<Dim, Scalar>> xA(A.data(), _(dim), _(dim));
+                    Eigen::Map<detail::fixed_vector<Dim>> xx(x[i].data(), _(dim));
+                    Eigen::Map<const detail::fixed_vector<Dim>> xz(z[i].data(), _(dim));
+                    xx.noalias() = (xA * xz.template cast<Scalar>()).template cast<double>();
+                    xx += Eigen::Map<const detail::fixed_vector<Dim>>(mean.data(), _(dim));
+                });
             }
-            for (decltype(dim) j = 0u; j < dim; ++j) {
-                dumb[j] = x[i](_(j));
-            }
-            pop.set_x(i, dumb);
         }
+        nes::evaluate(pop, m_bfe, x, m_force_bounds && !batch);
 
         // 2 - Check the exit conditions and logs
         // Exit condition on xtol
         {
-            if ((A * z[0]).norm() < m_xtol) {
+            if ((A * z[0].template cast<Scalar>()).norm() < m_xtol) {
                 if (m_verbosity > 0u) {
                     std::cout << "Exit condition -- xtol < " << m_xtol << std::endl;
                 }
@@ -277,34 +329,10 @@ population xnes::evolve(population pop) const
             // Every m_verbosity generations print a log line
             if (gen % m_verbosity == 1u || m_verbosity == 1u) {
                 // The population flatness in chromosome
-                auto dx = (A * z[0]).norm();
-                // The population flatness in fitness
-                auto idx_b = pop.best_idx();
-                auto idx_w = pop.worst_idx();
-                auto df = std::abs(pop.get_f()[idx_b][0] - pop.get_f()[idx_w][0]);
-                // Every 50 lines print the column names
-                if (count % 50u == 1u) {
-                    print("\n", std::setw(7), "Gen:", std::setw(15), "Fevals:", std::setw(15), "Best:", std::setw(15),
-                          "dx:", std::setw(15), "df:", std::setw(15), "sigma:", '\n');
-                }
-                print(std::setw(7), gen, std::setw(15), prob.get_fevals() - fevals0, std::setw(15),
-                      pop.get_f()[idx_b][0], std::setw(15), dx, std::setw(15), df, std::setw(15), sigma, '\n');
-                ++count;
-                // Logs
-                m_log.emplace_back(gen, prob.get_fevals() - fevals0, pop.get_f()[idx_b][0], dx, df,
-                                   sigma);
-
-
+                double dx = (A * z[0].template cast<Scalar>()).norm();
+                nes::print_generation(m_log, count, gen, prob.get_fevals() - fevals0, pop, dx, sigma);
                 // Save genome to file
-
-                if (m_logger->is_genome()) {
-                    m_logger->save_hist_score(gen, &pop);
-                    std::vector<double> mean_val(mean.size());
-                    for (int i = 0; i < mean.size(); i++) {
-                        mean_val[i] = mean(_(i));
-                    }
-                    m_logger->save_to_file(gen, &mean_val[0], &pop);
-                }
+                nes::log_generation(m_logger, m_context, gen, mean, pop);
             }
         }
 
@@ -315,22 +343,33 @@ population xnes::evolve(population pop) const
             return pop.get_f()[a][0] < pop.get_f()[b][0];
         });
         // 4 - We update the distribution parameters mu, sigma and B following the xnes rules
-        Eigen::MatrixXd I = Eigen::MatrixXd::Identity(_(dim), _(dim));
-        Eigen::VectorXd d_center = u[0] * z[s_idx[0]];
-        for (decltype(u.size()) i = 1u; i < u.size(); ++i) {
-            d_center += u[i] * z[s_idx[i]];
-        }
-        Eigen::MatrixXd cov_grad = u[0] * (z[s_idx[0]] * z[s_idx[0]].transpose() - I);
-        for (decltype(u.size()) i = 1u; i < u.size(); ++i) {
-            cov_grad += u[i] * (z[s_idx[i]] * z[s_idx[i]].transpose() - I);
+        for (decltype(lam) i = 0u; i < lam; ++i) {
+            Z.col(_(i)) = z[s_idx[i]];
         }
-        double cov_trace = cov_grad.trace();
-        cov_grad = cov_grad - cov_trace / dim_d * I;
-        Eigen::MatrixXd d_A = 0.5 * (eta_sigma * cov_trace / dim_d * I + eta_b * cov_grad);
-        mean = mean + eta_mu * A * d_center;
-        A = A * d_A.exp();
+        // The gradient sum_i u_i (z_i z_i^T - I) is Z diag(u) Z^T minus a multiple of I, and so is
+        // d_A = 0.5 * (eta_sigma * cov_trace / dim_d * I + eta_b * (gradient - cov_trace / dim_d * I)): neither the
+        // gradient nor d_A is formed, and A * exp(d_A) is computed from its low rank part.
+        double u_sum = u_vec.sum();
+        double cov_trace = Z.colwise().squaredNorm().dot(u_vec) - dim_d * u_sum;
+        double alpha = 0.5 * (eta_sigma - eta_b) * cov_trace / dim_d - 0.5 * eta_b * u_sum;
+        // The mean moves by eta_mu * A * Z u (see fixed_dim.hpp)
+        detail::with_fixed_dim(dim, [&](auto fixed) {
+            constexpr int Dim = decltype(fixed)::value;
+            Eigen::Map<const detail::fixed_matrix<Dim, Scalar>> xA(A.data(), _(dim), _(dim));
+            Eigen::Map<const detail::fixed_columns<Dim>> xZ(Z.data(), _(dim), _(lam));
+            detail::fixed_vector<Dim> d_center = xZ * u_vec;
+            Eigen::Map<detail::fixed_vector<Dim>>(mean.data(), _(dim))
+                += eta_mu * (xA * d_center.template cast<Scalar>()).template cast<double>();
+        });
+        A = multiply_exp(A, alpha, Z, 0.5 * eta_b * u_vec);
         sigma = sigma * std::exp(eta_sigma / 2. * cov_trace / dim_d); // used only for cmaes comparisons
                                                                       //
+        // 5 - Save a checkpoint, from which evolve() resumes after this generation
+        if (m_checkpoint && m_checkpoint->due(gen)) {
+            m_gen_done = gen;
+            m_checkpoint->save(*this, gen, pop);
+            m_gen_done = 0u;
+        }
     }
 
     if (m_verbosity) {
@@ -343,19 +382,31 @@ population xnes::evolve(population pop) const
 /**
  * @param seed the seed controlling the algorithm stochastic behaviour
  */
-void xnes::set_seed(unsigned seed)
+template <typename Scalar>
+void xnes_t<Scalar>::set_seed(unsigned seed)
 {
     m_e.seed(seed);
     m_seed = seed;
 }
 
+/// Sets the batch function evaluation scheme
+/**
+ * @param b batch function evaluation object
+ */
+template <typename Scalar>
+void xnes_t<Scalar>::set_bfe(const bfe &b)
+{
+    m_bfe = b;
+}
+
 /// Extra info
 /**
  * One of the optional methods of any user-defined algorithm (UDA).
  *
  * @return a string containing extra info on the algorithm
  */
-std::string xnes::get_extra_info() const
+template <typename Scalar>
+std::string xnes_t<Scalar>::get_extra_info() const
 {
     std::ostringstream ss;
     stream(ss, "\tGenerations: ", m_gen);
@@ -387,19 +438,31 @@ std::string xnes::get_extra_info() const
     stream(ss, "\n\tStopping ftol: ", m_ftol);
     stream(ss, "\n\tMemory: ", m_memory);
     stream(ss, "\n\tForce bounds: ", m_force_bounds);
+    stream(ss, "\n\tPrecision of A: ", std::is_same<Scalar, float>::value ? "single" : "double");
     stream(ss, "\n\tVerbosity: ", m_verbosity);
     stream(ss, "\n\tSeed: ", m_seed);
     return ss.str();
 }
 
 // Object serialization
+template <typename Scalar>
 template <typename Archive>
-void xnes::serialize(Archive &ar, unsigned)
+void xnes_t<Scalar>::serialize(Archive &ar, unsigned)
 {
     detail::archive(ar, m_gen, m_eta_mu, m_eta_sigma, m_eta_b, m_sigma0, m_ftol, m_xtol, m_memory, m_force_bounds,
-                    sigma, mean, A, m_e, m_seed, m_verbosity, m_log);
+                    sigma, mean, A, m_e, m_seed, m_verbosity, m_log, m_bfe, m_gen_done);
 }
 
+// The double and single precision algorithms
+template class xnes_t<double>;
+template class xnes_t<float>;
+
+// The checkpoints of the evolution runs archive the algorithm in binary form (see checkpoint.hpp)
+template void xnes_t<double>::serialize(boost::archive::binary_oarchive &, unsigned);
+template void xnes_t<double>::serialize(boost::archive::binary_iarchive &, unsigned);
+template void xnes_t<float>::serialize(boost::archive::binary_oarchive &, unsigned);
+template void xnes_t<float>::serialize(boost::archive::binary_iarchive &, unsigned);
+
 } // namespace pagmo
 
  //PAGMO_S11N_ALGORITHM_IMPLEMENT(pagmo::xnes)
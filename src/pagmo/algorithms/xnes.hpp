@@ -35,14 +35,20 @@ see https://www.gnu.org/licenses/. */
 
 #include <string>
 #include <tuple>
+#include <type_traits>
 #include <vector>
 
+#include <boost/optional.hpp>
+
 #include <pagmo/algorithm.hpp>
+#include <pagmo/bfe.hpp>
 #include <pagmo/detail/eigen.hpp>
 #include <pagmo/detail/visibility.hpp>
 #include <pagmo/population.hpp>
 #include <pagmo/rng.hpp>
 
+#include "../checkpoint.hpp"
+#include "../eval_context.hpp"
 #include "../mylogger.hpp"
 
 namespace pagmo
@@ -89,10 +95,25 @@ namespace pagmo
  *    evolution strategies. In Proceedings of the 12th annual conference on Genetic and evolutionary computation (pp.
  *    393-400). ACM.
  * \endverbatim
+ *
+ * The N x N matrix A, the square root of the covariance matrix, is stored and updated in \p Scalar, while the mean,
+ * the step-size and the candidates stay in double. pagmo::xnes is the double precision algorithm; with \p Scalar
+ * float, A takes half the memory and its products and exponential run on twice as many SIMD lanes, for genomes of
+ * thousands of weights. A is updated multiplicatively, by the exponential of a symmetric matrix, so that the rounding
+ * errors stay relative to its own entries.
+ *
+ * @tparam Scalar double or float, the precision of A.
  */
-class PAGMO_DLL_PUBLIC xnes
+template <typename Scalar = double>
+class PAGMO_DLL_PUBLIC xnes_t
 {
+    static_assert(std::is_same<Scalar, double>::value || std::is_same<Scalar, float>::value,
+                  "The N x N matrix of xnes is stored in double or in float");
+
 public:
+    /// Type of the N x N matrix
+    typedef Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic> matrix_type;
+
     /// Single data line for the algorithm's log.
     /**
      * A log data line is a tuple consisting of:
@@ -131,9 +152,9 @@ public:
 
      * @throws std::invalid_argument if eta_mu, eta_sigma, eta_b and sigma0 are not in ]0, 1] or -1
      */
-    xnes(unsigned gen = 1, double eta_mu = -1, double eta_sigma = -1, double eta_b = -1, double sigma0 = -1,
-         double ftol = 1e-6, double xtol = 1e-6, bool memory = false, bool force_bounds = false, logger* log = nullptr,
-         unsigned seed = pagmo::random_device::next());
+    xnes_t(unsigned gen = 1, double eta_mu = -1, double eta_sigma = -1, double eta_b = -1, double sigma0 = -1,
+           double ftol = 1e-6, double xtol = 1e-6, bool memory = false, bool force_bounds = false,
+           logger *log = nullptr, unsigned seed = pagmo::random_device::next());
 
     // Algorithm evolve method
     population evolve(population) const;
@@ -200,15 +221,64 @@ public:
         return m_gen;
     }
 
+    /// Sets the initial step-size
+    /**
+     * Used by the next call to evolve() that resets the memory of the algorithm.
+     *
+     * @param sigma0 initial step-size, or -1 for the automatic value.
+     */
+    void set_sigma0(double sigma0)
+    {
+        m_sigma0 = sigma0;
+    }
+
+    /// Gets the initial step-size
+    /**
+     * @return the initial step-size
+     */
+    double get_sigma0() const
+    {
+        return m_sigma0;
+    }
+
+    /// Sets the bfe
+    void set_bfe(const bfe &b);
+
+    /// Sets the evaluation context
+    /**
+     * When a context is set, evolve() stops as soon as its run budget is spent.
+     *
+     * @param context evaluation context shared with the problem, or nullptr.
+     */
+    void set_eval_context(eval_context *context)
+    {
+        m_context = context;
+    }
+
+    /// Sets the checkpoints
+    /**
+     * When set, the state of the algorithm and the population are saved at the end of every generation after which a
+     * checkpoint is due, and an algorithm restored from a checkpoint resumes after its last generation (see
+     * pagmo::checkpoint).
+     *
+     * @param cp checkpoints of the run, or nullptr.
+     */
+    void set_checkpoint(checkpoint *cp)
+    {
+        m_checkpoint = cp;
+    }
+
     /// Algorithm name
     /**
-     * One of the optional methods of any user-defined algorithm (UDA).
+     * One of the optional methods of any user-defined algorithm (UDA). The single precision algorithm has its own
+     * name, so that a checkpoint is only resumed with the precision that saved it.
      *
      * @return a string containing the algorithm name
      */
     std::string get_name() const
     {
-        return "xNES: Exponential Natural Evolution Strategies";
+        return std::is_same<Scalar, float>::value ? "xNES: Exponential Natural Evolution Strategies (single precision)"
+                                                  : "xNES: Exponential Natural Evolution Strategies";
     }
 
     // Extra info
@@ -255,22 +325,31 @@ private:
     bool m_memory;
     bool m_force_bounds;
     logger* m_logger;
+    eval_context *m_context;
+    checkpoint *m_checkpoint;
 
     // "Memory" data members (these are adapted during each evolve call and may be remembered if m_memory is true)
     mutable double sigma;
     mutable Eigen::VectorXd mean;
-    mutable Eigen::MatrixXd A;
+    mutable matrix_type A;
+    // Generations done when checkpointed: evolve() resumes after them
+    mutable unsigned m_gen_done;
 
     // "Common" data members
     mutable detail::random_engine_type m_e;
     unsigned m_seed;
     unsigned m_verbosity;
     mutable log_type m_log;
+    boost::optional<bfe> m_bfe;
 };
 
+/// xNES in double precision
+using xnes = xnes_t<double>;
+
 } // namespace pagmo
 
 PAGMO_S11N_ALGORITHM_EXPORT_KEY(pagmo::xnes)
+PAGMO_S11N_ALGORITHM_EXPORT_KEY(pagmo::xnes_t<float>)
 
 #else // PAGMO_WITH_EIGEN3
 
@@ -0,0 +1,146 @@
+#ifndef PAGMO_CHECKPOINT_HPP
+#define PAGMO_CHECKPOINT_HPP
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include <pagmo/population.hpp>
+#include <pagmo/types.hpp>
+
+#include "eval_context.hpp"
+#include "mylogger.hpp"
+
+namespace pagmo {
+
+/// Periodic binary checkpoints of an evolution run
+/**
+ * A checkpoint holds the whole state of the algorithm as archived by its serialize() method
+ * (search distribution, step-size, random engine and number of generations done), the decision
+ * vectors and fitnesses of the population, the number of runs of the evaluation context and the
+ * size of the log files.
+ *
+ * The algorithms call save() at the end of every generation after which due() holds. A run is
+ * resumed with load(): the population is rebuilt without being evaluated again, the log files are
+ * cut back to their size at the checkpoint, and the algorithm goes on from the next generation as
+ * if it had never been interrupted. The simulation seeds derive from the random engine of the
+ * algorithm, so the resumed run evaluates the same simulations.
+ *
+ * The checkpoint is written to a temporary file first and then renamed, so that a run killed
+ * while saving keeps its previous checkpoint.
+ */
+class checkpoint {
+  public:
+    /// Constructor
+    /**
+     * @param path file the checkpoints are written to.
+     * @param every_gen save every that many generations, 0 to disable.
+     * @param every_minutes save when that many minutes went by since the last checkpoint, 0 to
+     * disable.
+     * @param context evaluation context whose run count is saved, or nullptr.
+     * @param log logger whose log files are cut back on resume, or nullptr.
+     */
+    checkpoint(std::string path, unsigned every_gen, double every_minutes,
+               eval_context* context = nullptr, logger* log = nullptr)
+        : m_path(std::move(path)), m_every_gen(every_gen), m_every_minutes(every_minutes),
+          m_context(context), m_logger(log), m_last(std::chrono::steady_clock::now()) {}
+
+    /// Whether a checkpoint is due at the end of generation \p gen
+    bool due(unsigned gen) const {
+        double minutes =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - m_last).count() / 60.;
+        return (m_every_gen > 0 && gen % m_every_gen == 0)
+               || (m_every_minutes > 0. && minutes >= m_every_minutes);
+    }
+
+    /// Save a checkpoint
+    /**
+     * @param algo the algorithm, which must have explicitly instantiated its serialize() method
+     * for the binary archives.
+     * @param gen the last generation done.
+     * @param pop the population at the end of generation \p gen.
+     */
+    template <typename Algo> void save(const Algo& algo, unsigned gen, const population& pop) {
+        std::string tmp_path = m_path + ".tmp";
+        {
+            std::ofstream os(tmp_path, std::ios::binary);
+            boost::archive::binary_oarchive oa(os);
+            std::string name = algo.get_name();
+            unsigned long long runs = m_context ? m_context->get_runs() : 0;
+            logger::log_position position;
+            if (m_logger) {
+                position = m_logger->get_position();
+            }
+            oa << name << gen << algo << pop.get_x() << pop.get_f() << runs
+               << position.hist_score << position.hist_runs << position.hist_batches;
+        }
+        if (std::rename(tmp_path.c_str(), m_path.c_str()) != 0) {
+            throw std::runtime_error("Cannot write the checkpoint " + m_path);
+        }
+        m_last = std::chrono::steady_clock::now();
+        std::cout << "Checkpoint of generation " << gen << " saved to " << m_path << std::endl;
+    }
+
+    /// Restore a checkpoint
+    /**
+     * @param path the checkpoint file.
+     * @param algo the algorithm, of the same type as the one that saved the checkpoint: its whole
+     * archived state is overwritten.
+     * @param pop an empty population of the problem, filled with the saved individuals.
+     *
+     * @return the last generation done.
+     *
+     * @throw std::runtime_error if the file cannot be read or was saved by another algorithm.
+     */
+    template <typename Algo> unsigned load(const std::string& path, Algo& algo, population& pop) {
+        std::ifstream is(path, std::ios::binary);
+        if (!is) {
+            throw std::runtime_error("Cannot read the checkpoint " + path);
+        }
+        boost::archive::binary_iarchive ia(is);
+        std::string name;
+        unsigned gen;
+        ia >> name;
+        if (name != algo.get_name()) {
+            throw std::runtime_error("The checkpoint " + path + " was saved by " + name
+                                     + ", not by " + algo.get_name());
+        }
+        std::vector<vector_double> x, f;
+        unsigned long long runs;
+        logger::log_position position;
+        ia >> gen >> algo >> x >> f >> runs >> position.hist_score >> position.hist_runs
+           >> position.hist_batches;
+        for (decltype(x.size()) i = 0; i < x.size(); i++) {
+            pop.push_back(x[i], f[i]);
+        }
+        if (m_context) {
+            m_context->set_runs(runs);
+        }
+        if (m_logger) {
+            m_logger->restore_position(position);
+        }
+        std::cout << "Resuming after generation " << gen << " from " << path << std::endl;
+        return gen;
+    }
+
+  private:
+    std::string m_path;
+    unsigned m_every_gen;
+    double m_every_minutes;
+    eval_context* m_context;
+    logger* m_logger;
+    std::chrono::steady_clock::time_point m_last;
+};
+
+} // namespace pagmo
+
+#endif
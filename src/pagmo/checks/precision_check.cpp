@@ -0,0 +1,120 @@
+// Check of the single precision CMA-ES: cmaes_t<float> converges on the sphere, a 1e6-conditioned
+// ellipsoid and Rosenbrock as cmaes_t<double> does, to the same fitness with about as many
+// evaluations.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <pagmo/population.hpp>
+#include <pagmo/problem.hpp>
+#include <pagmo/types.hpp>
+
+#include "../algorithms/cmaes.hpp"
+
+namespace {
+
+/// Bounds of the test problems, around their optimum
+std::pair<pagmo::vector_double, pagmo::vector_double> box(unsigned dim) {
+    return {pagmo::vector_double(dim, -5.), pagmo::vector_double(dim, 5.)};
+}
+
+struct sphere {
+    unsigned dim = 10u;
+    pagmo::vector_double fitness(const pagmo::vector_double& x) const {
+        double f = 0.;
+        for (double xi : x) {
+            f += xi * xi;
+        }
+        return {f};
+    }
+    std::pair<pagmo::vector_double, pagmo::vector_double> get_bounds() const { return box(dim); }
+};
+
+/// Axis-parallel ellipsoid, with a condition number of 1e6
+struct ellipsoid {
+    unsigned dim = 10u;
+    pagmo::vector_double fitness(const pagmo::vector_double& x) const {
+        double f = 0.;
+        for (unsigned i = 0u; i < dim; i++) {
+            f += std::pow(1e6, static_cast<double>(i) / (dim - 1u)) * x[i] * x[i];
+        }
+        return {f};
+    }
+    std::pair<pagmo::vector_double, pagmo::vector_double> get_bounds() const { return box(dim); }
+};
+
+struct rosenbrock {
+    unsigned dim = 10u;
+    pagmo::vector_double fitness(const pagmo::vector_double& x) const {
+        double f = 0.;
+        for (unsigned i = 0u; i + 1u < dim; i++) {
+            double valley = x[i + 1] - x[i] * x[i];
+            f += 100. * valley * valley + (1. - x[i]) * (1. - x[i]);
+        }
+        return {f};
+    }
+    std::pair<pagmo::vector_double, pagmo::vector_double> get_bounds() const { return box(dim); }
+};
+
+/// Median of the converged fitness and of the evaluations over a few seeds
+struct result {
+    double f;
+    unsigned long long fevals;
+};
+
+template <typename Scalar>
+result converge(const pagmo::problem& prob) {
+    const unsigned n_seeds = 5u;
+    auto lam = 4u + static_cast<unsigned>(3. * std::log(prob.get_nx()));
+    std::vector<double> fs;
+    std::vector<unsigned long long> fevals;
+    for (unsigned seed = 1u; seed <= n_seeds; seed++) {
+        pagmo::population pop{prob, lam, seed};
+        // Until the fitness of the population is flat to 1e-12, the generations being no limit
+        pagmo::cmaes_t<Scalar> algo(10000u, -1, -1, -1, -1, 0.3, 1e-12, 1e-12, false, false,
+                                    nullptr, seed);
+        pop = algo.evolve(pop);
+        fs.push_back(pop.champion_f()[0]);
+        fevals.push_back(pop.get_problem().get_fevals());
+    }
+    std::nth_element(fs.begin(), fs.begin() + n_seeds / 2u, fs.end());
+    std::nth_element(fevals.begin(), fevals.begin() + n_seeds / 2u, fevals.end());
+    return {fs[n_seeds / 2u], fevals[n_seeds / 2u]};
+}
+
+} // namespace
+
+int main() {
+    // The median run reaches the optimum to this fitness, in either precision
+    const double target = 1e-8;
+    bool passed = true;
+    std::cout << std::setw(12) << "Problem:" << std::setw(6) << "N:" << std::setw(15) << "f double:"
+              << std::setw(15) << "f float:" << std::setw(15) << "fevals double:" << std::setw(15)
+              << "fevals float:" << std::endl;
+    // 30 is one of the default ES_FIXED_DIMS, and 10 takes the dynamic path
+    for (unsigned dim : {10u, 30u}) {
+        std::vector<std::pair<std::string, pagmo::problem>> problems{
+            {"sphere", pagmo::problem{sphere{dim}}},
+            {"ellipsoid", pagmo::problem{ellipsoid{dim}}},
+            {"rosenbrock", pagmo::problem{rosenbrock{dim}}}};
+        for (const auto& [name, prob] : problems) {
+            auto d = converge<double>(prob);
+            auto f = converge<float>(prob);
+            std::cout << std::setw(12) << name << std::setw(6) << dim << std::setw(15) << d.f
+                      << std::setw(15) << f.f << std::setw(15) << d.fevals << std::setw(15)
+                      << f.fevals << std::endl;
+            if (!(d.f < target && f.f < target)) {
+                std::cerr << "FAILED: " << name << " " << dim << " does not converge to " << target
+                          << std::endl;
+                passed = false;
+            }
+        }
+    }
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,74 @@
+// Check of run_race: with as many task slots as runs in the batch, the race still holds back the
+// further runs of every candidate until its first ones are finished, and skips the runs of the
+// candidates that clearly lose.
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../problems/mpi_race.hpp"
+
+namespace {
+
+/// Evaluate a batch on a simulated farm of \p slots task slots that returns the runs in random
+/// order, the fitness of candidate c being c plus a standard normal noise
+int evaluate(pagmo::run_race& race, int runs, int slots, unsigned seed) {
+    std::mt19937 engine(seed);
+    std::normal_distribution<double> noise(0., 1.);
+    std::vector<int> running;
+    int n_runs = 0;
+    auto fill = [&]() {
+        int task;
+        while (static_cast<int>(running.size()) < slots && (task = race.next()) >= 0) {
+            running.push_back(task);
+        }
+    };
+    fill();
+    while (!running.empty()) {
+        std::size_t i = std::uniform_int_distribution<std::size_t>(0, running.size() - 1)(engine);
+        int c = running[i] / runs;
+        running.erase(running.begin() + i);
+        race.add(c, c + noise(engine));
+        n_runs++;
+        fill();
+    }
+    if (race.holding()) {
+        std::cerr << "Runs still held back at the end of the batch" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    return n_runs;
+}
+
+void check(bool condition, const char* message) {
+    if (!condition) {
+        std::cerr << "FAILED: " << message << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+} // namespace
+
+int main() {
+    const int n_candidates = 20;
+    const int runs = 10;
+    const int n_tasks = n_candidates * runs;
+
+    // Without racing, every run is done
+    pagmo::run_race plain(n_candidates, runs);
+    check(evaluate(plain, runs, n_tasks, 1u) == n_tasks, "all the runs without racing");
+
+    // With racing, on a farm that could take the whole batch at once
+    pagmo::run_race race(n_candidates, runs, true, 2, 2.);
+    int n_runs = evaluate(race, runs, n_tasks, 1u);
+    std::cout << "Racing: " << n_runs << " runs out of " << n_tasks << ", " << race.get_skipped()
+              << " skipped" << std::endl;
+    check(race.get_skipped() > 0, "the race skips runs");
+    check(n_runs + race.get_skipped() == n_tasks, "every run is either done or skipped");
+    check(race.is_dropped(n_candidates - 1), "the worst candidate is dropped");
+    check(!race.is_dropped(0) && race.get_done(0) == runs, "the best candidate gets all its runs");
+    for (int c = 0; c < n_candidates; c++) {
+        check(race.get_done(c) >= 2, "every candidate gets its minimum runs");
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+#ifndef PAGMO_EVAL_CONTEXT_HPP
+#define PAGMO_EVAL_CONTEXT_HPP
+
+#include <vector>
+
+#include "sampling.hpp"
+
+namespace pagmo {
+
+/// Outcome of one simulation run
+struct run_record {
+    /// Index of the candidate in the evaluated batch
+    unsigned candidate;
+    /// Index of the run among the runs of the candidate
+    unsigned run;
+    /// Simulation seed
+    unsigned seed;
+    /// Rank of the process that ran the simulation
+    int worker;
+    /// Fitness of the run (to be minimised)
+    double fitness;
+    /// Number of simulated steps
+    unsigned long steps;
+    /// Wall-clock duration of the run, in seconds
+    double seconds;
+    /// Whether the run was returned first by a speculative copy of its task
+    bool speculative;
+};
+
+/// Counters of an evaluated batch
+struct batch_stats {
+    /// Runs of the batch, and those actually performed (fewer with racing)
+    unsigned tasks = 0;
+    unsigned runs = 0;
+    /// Speculative copies dispatched, and those that returned first
+    unsigned copies = 0;
+    unsigned copies_won = 0;
+    /// Results dropped: of a revoked process, of a copy that lost or of a previous batch
+    unsigned late_results = 0;
+};
+
+/// Search distribution and candidate seeds of a batch, in the seeded sampling mode
+struct sampling_batch {
+    /// Distribution the candidates are drawn from
+    sampling_state state;
+    /// Seed of each candidate (see sample_candidate()), empty when no batch is pending
+    std::vector<unsigned> seeds;
+};
+
+/// Bookkeeping shared by the evaluator and the algorithms
+/**
+ * One instance is created by the main program and given by pointer to the problem, which
+ * records every simulation run it performs, and to the algorithms, which stop when the run
+ * budget is spent. The number of runs per candidate is not fixed (see mpi_thread racing), so the
+ * budget cannot be turned into a number of generations beforehand.
+ *
+ * The runs of the last evaluated batch are kept in a table, so that the algorithms and the
+ * logger can look at the per-run fitnesses, lengths and durations behind the mean fitness, along
+ * with the counters of the batch (racing, speculation and dropped results).
+ *
+ * In the seeded sampling mode, the algorithms draw their candidates with sample_candidate() and
+ * leave the distribution and the candidate seeds of the batch they are about to evaluate in the
+ * context: the evaluator can then send the seeds instead of the decision vectors.
+ */
+class eval_context {
+  public:
+    /// Constructor
+    /**
+     * @param run_budget total number of simulation runs, 0 for no limit.
+     */
+    explicit eval_context(unsigned long long run_budget = 0)
+        : m_run_budget(run_budget), m_runs(0), m_seeded_sampling(false) {}
+
+    /// Enable the seeded sampling mode
+    void set_seeded_sampling(bool seeded_sampling) { m_seeded_sampling = seeded_sampling; }
+
+    /// Whether the algorithms must sample their candidates with sample_candidate()
+    bool get_seeded_sampling() const { return m_seeded_sampling; }
+
+    /// Distribution and candidate seeds of the next batch, filled by the algorithm and consumed
+    /// (its seeds cleared) by the evaluator
+    sampling_batch& get_sampling_batch() { return m_sampling_batch; }
+
+    /// Start a new batch: clears the run table and the counters
+    void begin_batch() {
+        m_run_table.clear();
+        m_batch_stats = batch_stats();
+    }
+
+    /// Record one more simulation run
+    void add_run(const run_record& record) {
+        m_run_table.push_back(record);
+        m_runs++;
+    }
+
+    /// Runs of the last evaluated batch, in completion order
+    const std::vector<run_record>& get_run_table() const { return m_run_table; }
+
+    /// Counters of the last evaluated batch, filled by the evaluator
+    batch_stats& get_batch_stats() { return m_batch_stats; }
+    const batch_stats& get_batch_stats() const { return m_batch_stats; }
+
+    /// Number of simulation runs performed so far
+    unsigned long long get_runs() const { return m_runs; }
+
+    /// Restore the number of simulation runs of a checkpointed run
+    void set_runs(unsigned long long runs) { m_runs = runs; }
+
+    /// Total number of simulation runs allowed, 0 for no limit
+    unsigned long long get_run_budget() const { return m_run_budget; }
+
+    /// Whether the run budget is spent
+    bool budget_exhausted() const { return m_run_budget != 0 && m_runs >= m_run_budget; }
+
+  private:
+    unsigned long long m_run_budget;
+    unsigned long long m_runs;
+    std::vector<run_record> m_run_table;
+    batch_stats m_batch_stats;
+    bool m_seeded_sampling;
+    sampling_batch m_sampling_batch;
+};
+
+} // namespace pagmo
+
+#endif
@@ -1,8 +1,28 @@
 // logger by Ken H
 
 #include "mylogger.hpp"
+#include <filesystem>
 #include <pagmo/io.hpp>
 
+namespace {
+
+std::uintmax_t file_size(const char* filename) {
+    std::error_code error;
+    std::uintmax_t size = std::filesystem::file_size(filename, error);
+    return error ? 0 : size;
+}
+
+void restore_file(const char* filename, std::uintmax_t size) {
+    if (size == 0) {
+        // The header is written again with the first line
+        std::filesystem::remove(filename);
+    } else if (file_size(filename) > size) {
+        std::filesystem::resize_file(filename, size);
+    }
+}
+
+} // namespace
+
 logger::logger() {
     m_is_genome = false;
     // log file
@@ -29,6 +49,56 @@ void logger::save_hist_score(int generation, pagmo::population* pop) {
     os.close();
 }
 
+void logger::save_run_table(int generation, const pagmo::eval_context& context) {
+
+    std::ifstream f("hist_runs.txt");
+    bool new_file = not f.good();
+    f.close();
+
+    std::ofstream os("hist_runs.txt", std::ios_base::app);
+    if (new_file) {
+        os << "generation,candidate,run,seed,worker,fitness,steps,seconds,speculative" << std::endl;
+    }
+
+    for (const auto& record : context.get_run_table()) {
+        os << generation << "," << record.candidate << "," << record.run << "," << record.seed
+           << "," << record.worker << "," << -record.fitness << "," << record.steps << ","
+           << record.seconds << "," << record.speculative << std::endl;
+    }
+    os.close();
+
+    f.open("hist_batches.txt");
+    new_file = not f.good();
+    f.close();
+
+    std::ofstream batches("hist_batches.txt", std::ios_base::app);
+    if (new_file) {
+        batches << "generation,tasks,runs,copies,copies_won,late_results" << std::endl;
+    }
+
+    const auto& stats = context.get_batch_stats();
+    batches << generation << "," << stats.tasks << "," << stats.runs << "," << stats.copies << ","
+            << stats.copies_won << "," << stats.late_results << std::endl;
+    batches.close();
+}
+
+void logger::save_restart(unsigned restart, const std::string& regime, unsigned long long runs,
+                          unsigned lambda, double sigma0, double best) {
+
+    std::ifstream f("hist_restarts.txt");
+    bool new_file = not f.good();
+    f.close();
+
+    std::ofstream os("hist_restarts.txt", std::ios_base::app);
+    if (new_file) {
+        os << "restart,regime,runs,lambda,sigma0,fitness" << std::endl;
+    }
+
+    os << restart << "," << regime << "," << runs << "," << lambda << "," << sigma0 << "," << -best
+       << std::endl;
+    os.close();
+}
+
 void logger::save_to_file(int generation, double* mean, pagmo::population* pop) {
 
     std::string filename = "gen/champ_" + std::to_string(generation) + ".dat";
@@ -62,6 +132,20 @@ void logger::save_to_file(int generation, double* mean, pagmo::population* pop)
     os.close();
 }
 
+logger::log_position logger::get_position() const {
+    log_position position;
+    position.hist_score = file_size("hist_score.txt");
+    position.hist_runs = file_size("hist_runs.txt");
+    position.hist_batches = file_size("hist_batches.txt");
+    return position;
+}
+
+void logger::restore_position(const log_position& position) const {
+    restore_file("hist_score.txt", position.hist_score);
+    restore_file("hist_runs.txt", position.hist_runs);
+    restore_file("hist_batches.txt", position.hist_batches);
+}
+
 void logger::set_genome(NEAT::Genome* genome) {
     m_startgen = genome;
     m_is_genome = true;
@@ -3,17 +3,32 @@
 #define PAGMO_MYLOGGER_HPP
 
 #include "../NEAT/genome.h"
+#include "eval_context.hpp"
+#include <cstdint>
 #include <pagmo/population.hpp>
 #include <string>
 
 class logger {
   public:
+    /// Size in bytes of the log files that are appended to, 0 if missing
+    struct log_position {
+        std::uintmax_t hist_score = 0;
+        std::uintmax_t hist_runs = 0;
+        std::uintmax_t hist_batches = 0;
+    };
+
     logger();
     logger(bool is_genome, NEAT::Genome* genome);
     bool is_genome();
     void save_hist_score(int generation, pagmo::population* pop);
     void save_to_file(int generation, double* mean, pagmo::population* pop);
+    void save_run_table(int generation, const pagmo::eval_context& context);
+    void save_restart(unsigned restart, const std::string& regime, unsigned long long runs,
+                      unsigned lambda, double sigma0, double best);
     void set_genome(NEAT::Genome* genome);
+    log_position get_position() const;
+    // Cut the log files back to a position, dropping what was logged after it
+    void restore_position(const log_position& position) const;
 
   private:
     // The individuals are of format genome
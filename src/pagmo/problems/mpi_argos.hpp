@@ -8,11 +8,152 @@
 #ifndef PAGMO_MYPROBLEM
 #define PAGMO_MYPROBLEM
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <memory>
 #include <mpi.h>
 #include <pagmo/problem.hpp>
+#include <pagmo/rng.hpp>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../eval_context.hpp"
+#include "mpi_protocol.hpp"
+#include "mpi_race.hpp"
+#include "mpi_shared.hpp"
 
 namespace pagmo {
 
+/// Evaluation options of mpi_thread
+struct mpi_options {
+    /// Evaluate all the candidates of a generation on the same seeds
+    bool common_seeds = false;
+    /// Stop dispatching the runs of the candidates that cannot reach the elite anymore
+    bool racing = false;
+    /// Number of finished runs every candidate gets before the race can drop it
+    int race_min_runs = 2;
+    /// Half-width of the confidence interval of the race, in standard errors
+    double race_width = 2.;
+    /// Number of tasks queued on each process, at most mpi_protocol::max_prefetch
+    int prefetch = 2;
+    /// Seconds a process with pending tasks may go without returning a result before it is
+    /// considered stuck and its tasks are dispatched to the others, 0 to wait forever. It must
+    /// exceed the duration of a run, and the start-up of a scheduler with respawn. The
+    /// collective messages of the shared generation matrix and of the seeded sampling mode would
+    /// block on a stuck process: they must not be used with a timeout.
+    double task_timeout = 0.;
+    /// Spawn a new scheduler process in place of each stuck one
+    bool respawn = false;
+    /// Number of speculative copies of a task that may run besides the original one, on the
+    /// processes left idle at the end of a batch, 0 to disable
+    int speculation = 0;
+    /// Scheduler binary and arguments, as given to MPI::COMM_WORLD.Spawn, to respawn processes
+    std::string scheduler_binary;
+    const char** scheduler_argv = nullptr;
+};
+
+/// A scheduler process
+struct mpi_worker {
+    /// Intercommunicator to the process
+    MPI::Intercomm comm;
+    /// Rank of the process in comm
+    int rank;
+    /// Whether the process was respawned, alone in its own intercommunicator
+    bool spawned;
+    /// Whether tasks are dispatched to the process
+    bool alive;
+};
+
+/// Messages to the scheduler processes, sent without blocking
+/**
+ * A scheduler only posts mpi_protocol::max_prefetch receives, and the cancellations take them as
+ * well as the tasks: a send may thus stay pending for as long as a simulation runs. Rather than
+ * waiting for it before reusing its buffer, which would leave the results of the other processes
+ * unread, every message gets a buffer of its own, taken from the ones whose send completed.
+ */
+struct mpi_outbox {
+    /// A message and its pending send
+    struct message {
+        /// Index of the process the message was sent to
+        int worker = -1;
+        std::vector<char> buffer;
+        MPI::Request request;
+    };
+
+    /// Buffer of a new message to process \p worker, reused from a completed send if possible
+    message& take(int worker) {
+        auto free = std::find_if(messages.begin(), messages.end(),
+                                 [](message& m) { return m.request.Test(); });
+        if (free == messages.end()) {
+            messages.emplace_back();
+            free = messages.end() - 1;
+        }
+        free->worker = worker;
+        return *free;
+    }
+
+    /// Give up the pending sends to process \p worker, which may never complete: MPI frees them,
+    /// and their buffers are moved to \p abandoned, which must outlive them
+    void abandon(int worker, std::vector<std::vector<char>>& abandoned) {
+        for (auto& m : messages) {
+            if (m.worker == worker && m.request != MPI::REQUEST_NULL) {
+                m.request.Free();
+                abandoned.push_back(std::move(m.buffer));
+                m.buffer.clear();
+            }
+        }
+    }
+
+    /// Wait for all the pending sends
+    void wait_all() {
+        for (auto& m : messages) {
+            m.request.Wait();
+        }
+    }
+
+    /// The messages: a deque, so that taking a new one leaves the others in place
+    std::deque<message> messages;
+};
+
+/// Scheduler processes and dispatch state of an mpi_thread
+/**
+ * pagmo copies the problem freely (island, population, extract), and any copy may evaluate. The
+ * copies share one farm, so that they all see the processes revoked or respawned by any of them,
+ * never reuse a batch number, which would let a stale result pass for a current one, and keep
+ * the buffers of the pending sends alive as long as any of them.
+ */
+struct mpi_farm {
+    /// Candidate evaluated asynchronously, see mpi_thread::async_submit()
+    struct async_candidate {
+        vector_double x;
+        std::vector<unsigned> seeds;
+        int n_done;
+        double sum;
+        bool in_flight;
+    };
+
+    /// Scheduler processes, built on first use
+    std::vector<mpi_worker> workers;
+    /// Processes replaced by a new one, still sent the end signal
+    std::vector<mpi_worker> replaced;
+    /// Messages to the processes whose send may be pending
+    mpi_outbox outbox;
+    /// Buffers of the sends to the revoked processes, which may never complete: MPI may read
+    /// them until the end of the run
+    std::vector<std::vector<char>> abandoned;
+    /// Number of the current batch, echoed back by the schedulers with the results
+    unsigned batch = 0;
+    /// Asynchronous candidates by ID, and asynchronous tasks not dispatched yet and queued on
+    /// each process
+    std::vector<async_candidate> async;
+    std::deque<int> async_pending;
+    std::vector<std::deque<int>> async_queued;
+};
+
 struct mpi_thread {
     /// Constructor from dimension
     /**
@@ -22,9 +163,12 @@ struct mpi_thread {
      */
 
     mpi_thread(int proc = 0, int dim = 0, int runs = 0, double lbound = 0, double ubound = 0,
-               MPI::Intercomm g_com = 0)
+               MPI::Intercomm g_com = 0, unsigned seed = pagmo::random_device::next(),
+               mpi_options options = mpi_options(), eval_context* context = nullptr,
+               mpi_shared_generation* shared = nullptr)
         : m_proc(proc), m_dim(dim), m_runs(runs), m_lbound(lbound), m_ubound(ubound),
-          m_g_com(g_com) {
+          m_g_com(g_com), m_e(seed), m_seed(seed), m_options(options), m_context(context),
+          m_shared(shared), m_farm(std::make_shared<mpi_farm>()) {
         m_thread_safety = thread_safety::none;
         m_has_batch_fitness = true;
     };
@@ -37,56 +181,503 @@ struct mpi_thread {
      * @return the fitness of \p x.
      */
     vector_double fitness(const vector_double& x) const {
-        std::cout << "Entered single fitness" << std::endl;
-        MPI::Status status;
-        double retval;
-        bool cont = true;
-
-        int proc_used = 0;
-        // Send continue value to binary
-        m_g_com.Send(&cont, 1, MPI::BOOL, proc_used, 1);
-        m_g_com.Send(&m_runs, 1, MPI::INT, proc_used, 1);
-        m_g_com.Send(x.data(), m_dim, MPI::DOUBLE, proc_used, 1);
-        m_g_com.Recv(&retval, 1, MPI::DOUBLE, proc_used, MPI::ANY_TAG, status);
-
-        return {retval};
+        // The runs of a single candidate are spread over the processes as well
+        return {batch_fitness(x)[0]};
     }
 
     bool has_batch_fitness() const { return m_has_batch_fitness; }
 
+    /// Batch fitness computation
+    /**
+     * Each candidate is split into \p m_runs tasks, one per simulation run, so that the runs of
+     * a candidate are spread across the processes. The tasks are handed out as a work queue:
+     * every process first gets mpi_options::prefetch tasks, then each time a process returns a
+     * fitness it is immediately given the next pending one. A process thus always has its next
+     * task queued when a simulation ends, and never waits for the master to handle its result.
+     *
+     * A task is a single packed message (see mpi_protocol::pack_task()) sent without blocking, so
+     * that the master goes on collecting results while it is delivered. The task ID of run \p r
+     * of candidate \p c is <tt>c * m_runs + r</tt>; it is part of the message header and the
+     * scheduler echoes it in the results it sends back. The fitness of a candidate is
+     * the mean over its runs.
+     *
+     * With a shared generation matrix (see mpi_shared_generation), \p dvs is published once per
+     * node before dispatching, and the tasks only carry the row of their candidate.
+     *
+     * In the seeded sampling mode (see eval_context::get_seeded_sampling()), when the algorithm
+     * left the distribution and the seeds of the \p n_dvs candidates in the context, the
+     * distribution is broadcast once and the tasks only carry the seed of their candidate: the
+     * schedulers rebuild it with sample_candidate(), the kernel the algorithm drew \p dvs with.
+     *
+     * The simulation seed of every task is drawn here from the problem's random engine, which the
+     * algorithms reseed from their own engine at every generation (see set_seed()), so that the
+     * evaluations of a run are reproducible from the algorithm seed.
+     *
+     * With common random numbers (mpi_options::common_seeds), only \p m_runs seeds are drawn:
+     * they are broadcast once to all the processes and run \p r of every candidate uses seed \p r,
+     * so that all the candidates of a generation are compared on the same simulations.
+     *
+     * The tasks are dispatched run by run: run 0 of every candidate, then run 1, and so on (see
+     * run_race). With racing (mpi_options::racing), only mpi_options::race_min_runs runs of every
+     * candidate are dispatched up front; its further runs wait until these are finished, and the
+     * candidate is dropped before any of them if its confidence interval lies entirely above those
+     * of the best half of the population. Its fitness is then the mean of the runs it got.
+     *
+     * With a task timeout (mpi_options::task_timeout), the master polls for the results instead of
+     * blocking. A process that holds tasks and returned no result for that long is considered
+     * stuck: it gets no more tasks, its tasks are dispatched again to the other processes, and
+     * the results it may still send for them are dropped. With mpi_options::respawn a new process
+     * is spawned in its place. Common random numbers then send the seeds themselves rather than
+     * indices into a broadcast table.
+     *
+     * With speculation (mpi_options::speculation), once no task is pending, a process that falls
+     * idle gets a copy of the task that has been running the longest on another process, with
+     * the same seed. The first copy to return wins: the others are cancelled (see
+     * mpi_protocol::op_cancel), which skips them if they have not started yet, and their results
+     * are dropped otherwise. The runs won by a copy are flagged in the run table.
+     *
+     * @param dvs the decision vectors, stored contiguously.
+     *
+     * @return the fitnesses of the candidates in \p dvs.
+     *
+     * @throw std::runtime_error if all the processes are stuck.
+     */
     vector_double batch_fitness(const vector_double& dvs) const {
-        std::cout << "Entered batch fitness" << std::endl;
         int n_dvs = dvs.size() / m_dim;
-        vector_double retval(n_dvs);
+        int n_tasks = n_dvs * m_runs;
+        vector_double retval(n_dvs, 0.);
+        m_farm->batch++;
 
-        int nGroup = ceil((double)n_dvs / m_proc);
-        int ind;
-        bool cont = true;
-        double dFitness;
-        MPI::Status status;
+        std::vector<unsigned> seeds(m_options.common_seeds ? m_runs : n_tasks);
+        for (auto& seed : seeds) {
+            seed = static_cast<unsigned>(m_e());
+        }
+        if (seed_table()) {
+            broadcast_seeds(seeds);
+        }
+        // Distribution and seeds of the candidates, if the schedulers can rebuild them
+        const sampling_batch* sampling = nullptr;
+        if (m_context && m_context->get_seeded_sampling()
+            && m_context->get_sampling_batch().seeds.size() == static_cast<std::size_t>(n_dvs)) {
+            sampling = &m_context->get_sampling_batch();
+            broadcast_sampling_state(sampling->state);
+        } else if (m_shared) {
+            publish_generation(dvs, n_dvs);
+        }
+
+        // Dispatch order and statistics of the finished runs of each candidate
+        run_race race(n_dvs, m_runs, m_options.racing, m_options.race_min_runs,
+                      m_options.race_width);
+        int n_runs = 0;
+        if (m_context) {
+            m_context->begin_batch();
+        }
 
-        for (int r = 0; r < nGroup; r++) {
-            std::cout << "Group: " << r << std::endl;
-            for (int p = 0; p < m_proc && p + r * m_proc < n_dvs; p++) {
-                std::cout << "Process: " << p << std::endl;
-                ind = p + r * m_proc;
-                const double* data_ptr = dvs.data() + ind * m_dim;
+        // Tasks of the stuck processes, dispatched again before the others
+        std::deque<int> retry;
 
-                m_g_com.Send(&cont, 1, MPI::BOOL, p, 1);
-                m_g_com.Send(&m_runs, 1, MPI::INT, p, 1);
-                m_g_com.Send(data_ptr, m_dim, MPI::DOUBLE, p, 1);
+        // Next task in dispatch order, or -1 when there is none to dispatch for now
+        auto next_task = [&]() {
+            if (!retry.empty()) {
+                int task = retry.front();
+                retry.pop_front();
+                return task;
             }
+            return race.next();
+        };
 
-            for (int p = 0; p < m_proc && p + r * m_proc < n_dvs; p++) {
-                m_g_com.Recv(&dFitness, 1, MPI::DOUBLE, MPI::ANY_SOURCE, MPI::ANY_TAG, status);
-                ind = r * m_proc + status.Get_source();
+        int task;
+        int in_flight = 0;
+        vector_double result;
+        init_workers();
+        int depth = std::max(1, std::min(m_options.prefetch, mpi_protocol::max_prefetch));
+        // Tasks queued on each process, oldest first, number of queued copies of each task,
+        // whether a copy of each task returned, and process and time of the original (not
+        // speculative) copy of each task
+        std::vector<std::deque<int>> queued(m_proc);
+        std::vector<int> copies(n_tasks, 0);
+        std::vector<bool> finished(n_tasks, false);
+        std::vector<int> original(n_tasks, -1);
+        std::vector<std::chrono::steady_clock::time_point> started(n_tasks);
+        int n_copies = 0;
+        int n_copies_won = 0;
+        int n_late = 0;
+        // Time of the last result of each process, or of its first task if it was idle
+        std::vector<std::chrono::steady_clock::time_point> last_active(m_proc);
+        auto dispatch = [&](int p, int task, bool speculative = false) {
+            send_task(p, task, task_seed(task, seeds), dvs.data() + (task / m_runs) * m_dim,
+                      sampling);
+            auto now = std::chrono::steady_clock::now();
+            if (queued[p].empty()) {
+                last_active[p] = now;
+            }
+            if (!speculative) {
+                original[task] = p;
+                started[task] = now;
+            }
+            queued[p].push_back(task);
+            copies[task]++;
+            in_flight++;
+        };
+        // Give idle process p a copy of the task running the longest on another process
+        auto speculate = [&](int p) {
+            int oldest = -1;
+            for (int q = 0; q < m_proc; q++) {
+                for (int t : queued[q]) {
+                    if (q != p && !finished[t] && copies[t] <= m_options.speculation
+                        && std::find(queued[p].begin(), queued[p].end(), t) == queued[p].end()
+                        && (oldest < 0 || started[t] < started[oldest])) {
+                        oldest = t;
+                    }
+                }
+            }
+            if (oldest >= 0) {
+                dispatch(p, oldest, true);
+                n_copies++;
+            }
+        };
+        // Hand the next pending task to process p, which just freed a place in its queue, or a
+        // speculative copy if there is none left
+        auto refill = [&](int p) {
+            int next_one = next_task();
+            if (next_one >= 0) {
+                dispatch(p, next_one);
+            } else if (m_options.speculation > 0 && queued[p].empty() && !race.holding()) {
+                speculate(p);
+            }
+        };
+        // Fill the queues of all the processes with the tasks that can be dispatched, or give the
+        // idle ones a speculative copy
+        auto top_up = [&]() {
+            for (int p = 0; p < m_proc; p++) {
+                while (m_farm->workers[p].alive && queued[p].size() < std::size_t(depth)
+                       && (task = next_task()) >= 0) {
+                    dispatch(p, task);
+                }
+                if (m_farm->workers[p].alive && queued[p].empty()) {
+                    refill(p);
+                }
+            }
+        };
 
-                retval[ind] = dFitness;
+        // Fill the queues level by level, so that every process gets a task before any gets two
+        for (int d = 0; d < depth; d++) {
+            for (int p = 0; p < m_proc; p++) {
+                if (m_farm->workers[p].alive && (task = next_task()) >= 0) {
+                    dispatch(p, task);
+                }
             }
         }
+
+        while (in_flight > 0) {
+            // Per-run results of a task: fitness, simulated steps and wall-clock time
+            int p = receive_result(result, task);
+            if (p == -2) {
+                // Nothing arrived: look for stuck processes
+                auto now = std::chrono::steady_clock::now();
+                bool revoked = false;
+                for (p = 0; p < m_proc; p++) {
+                    if (!m_farm->workers[p].alive || queued[p].empty()
+                        || std::chrono::duration<double>(now - last_active[p]).count()
+                               <= m_options.task_timeout) {
+                        continue;
+                    }
+                    std::cout << "Scheduler " << p << " stuck: dispatching its "
+                              << queued[p].size() << " tasks again" << std::endl;
+                    for (int t : queued[p]) {
+                        // Unless a copy of it is still running elsewhere
+                        if (--copies[t] == 0) {
+                            retry.push_back(t);
+                        }
+                        in_flight--;
+                    }
+                    queued[p].clear();
+                    // The sends to the process may never complete: keep their buffers alive as
+                    // long as any copy of the problem
+                    m_farm->outbox.abandon(p, m_farm->abandoned);
+                    revoke_worker(p);
+                    revoked = true;
+                }
+                if (revoked) {
+                    if (std::none_of(m_farm->workers.begin(), m_farm->workers.end(),
+                                     [](const mpi_worker& w) { return w.alive; })) {
+                        throw std::runtime_error("All the scheduler processes are stuck");
+                    }
+                    top_up();
+                } else {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                }
+                continue;
+            }
+            // Results of a revoked process, or of a copy that lost, in this batch or a previous one
+            bool current = p >= 0 && result.at(0) == m_farm->batch;
+            auto queued_task = current ? std::find(queued[p].begin(), queued[p].end(), task)
+                                       : queued[0].end();
+            if (!current || queued_task == queued[p].end() || finished[task]) {
+                n_late++;
+                // A copy of this batch that lost the race but had already started: its process
+                // is free for another task, unless it was refilled to the full when cancelled
+                if (current && m_farm->workers[p].alive && queued[p].size() < std::size_t(depth)) {
+                    refill(p);
+                }
+                continue;
+            }
+            queued[p].erase(queued_task);
+            copies[task]--;
+            finished[task] = true;
+            last_active[p] = std::chrono::steady_clock::now();
+            if (p != original[task]) {
+                n_copies_won++;
+            }
+            // Cancel the other copies. A copy that has not started yet is skipped without a
+            // result, so its process gets another task right away, once all the copies are gone
+            std::vector<int> freed;
+            for (int q = 0; q < m_proc && copies[task] > 0; q++) {
+                auto copy = std::find(queued[q].begin(), queued[q].end(), task);
+                if (copy != queued[q].end()) {
+                    queued[q].erase(copy);
+                    copies[task]--;
+                    in_flight--;
+                    cancel_task(q, task);
+                    freed.push_back(q);
+                }
+            }
+            for (int q : freed) {
+                if (m_farm->workers[q].alive && queued[q].size() < std::size_t(depth)) {
+                    refill(q);
+                }
+            }
+            int c = task / m_runs;
+            bool held = race.holding();
+            for (std::size_t k = mpi_protocol::result_header_size; k < result.size();
+                 k += mpi_protocol::result_run_size) {
+                double f = result[k];
+                race.add(c, f);
+                n_runs++;
+                if (m_context) {
+                    run_record record;
+                    record.candidate = c;
+                    record.run = task % m_runs + (k - mpi_protocol::result_header_size)
+                                                     / mpi_protocol::result_run_size;
+                    record.seed = m_options.common_seeds ? seeds[record.run]
+                                                         : seeds[c * m_runs + record.run];
+                    record.worker = p;
+                    record.speculative = p != original[task];
+                    record.fitness = f;
+                    record.steps = static_cast<unsigned long>(result[k + 1]);
+                    record.seconds = result[k + 2];
+                    m_context->add_run(record);
+                }
+            }
+            in_flight--;
+
+            // Hand the next pending task to the process that just finished, and the runs the race
+            // may have released to the processes left idle
+            refill(p);
+            if (held) {
+                top_up();
+            }
+        }
+        m_farm->outbox.wait_all();
+        if (m_context) {
+            m_context->get_sampling_batch().seeds.clear();
+        }
+
+        // The fitness of a candidate without finished runs is left at 0
+        for (int c = 0; c < n_dvs; c++) {
+            retval[c] = race.get_mean(c);
+        }
+        if (m_context) {
+            auto& stats = m_context->get_batch_stats();
+            stats.tasks = n_tasks;
+            stats.runs = n_runs;
+            stats.copies = n_copies;
+            stats.copies_won = n_copies_won;
+            stats.late_results = n_late;
+        }
         return retval;
     }
 
+    /// Start the evaluation of a candidate without waiting for its fitness
+    /**
+     * The asynchronous counterpart of batch_fitness(), for the algorithms that update their
+     * state whenever a few candidates are done (see pagmo::async_cmaes) rather than once per
+     * generation. The \p m_runs runs of the candidate are queued behind the ones submitted
+     * before and dispatched as the processes free up, mpi_options::prefetch tasks deep, by
+     * async_submit() and async_collect() alike: the candidates must be submitted ahead of time
+     * (see get_async_capacity()) to keep all the processes busy.
+     *
+     * Every run gets its own seed, drawn from the problem's random engine, and the weights are
+     * sent with each task. Racing, common random numbers, speculation, the shared generation
+     * matrix and the seeded sampling mode only apply to batch_fitness(), and stuck processes are
+     * not looked for. No batch_fitness() call may happen while candidates are in flight.
+     *
+     * @param x the decision vector.
+     *
+     * @return the ID of the candidate, reused once its fitness is collected.
+     */
+    int async_submit(const vector_double& x) const {
+        init_workers();
+        if (m_farm->async_queued.empty()) {
+            m_farm->async_queued.resize(m_proc);
+        }
+        // A new batch number when nothing is in flight tells apart the late results of the
+        // previous batch
+        if (get_async_in_flight() == 0) {
+            m_farm->batch++;
+        }
+        int id = 0;
+        while (id < static_cast<int>(m_farm->async.size()) && m_farm->async[id].in_flight) {
+            id++;
+        }
+        if (id == static_cast<int>(m_farm->async.size())) {
+            m_farm->async.emplace_back();
+        }
+        auto& candidate = m_farm->async[id];
+        candidate.x = x;
+        candidate.seeds.resize(m_runs);
+        for (auto& seed : candidate.seeds) {
+            seed = static_cast<unsigned>(m_e());
+        }
+        candidate.n_done = 0;
+        candidate.sum = 0.;
+        candidate.in_flight = true;
+        for (int r = 0; r < m_runs; r++) {
+            m_farm->async_pending.push_back(id * m_runs + r);
+        }
+        async_dispatch();
+        return id;
+    }
+
+    /// Wait until all the runs of a submitted candidate are done
+    /**
+     * The results are recorded in the evaluation context as they arrive, the runs of candidate
+     * ID \p id with candidate index \p id.
+     *
+     * @param fitness set to the fitness of the candidate, the mean over its runs.
+     *
+     * @return the ID of the candidate, as returned by async_submit(), or -1 if no candidate is in
+     * flight.
+     */
+    int async_collect(double& fitness) const {
+        int task;
+        vector_double result;
+        while (get_async_in_flight() > 0) {
+            int p = receive_result(result, task);
+            if (p == -2) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                continue;
+            }
+            bool current = p >= 0 && result.at(0) == m_farm->batch;
+            auto queued_task = current ? std::find(m_farm->async_queued[p].begin(),
+                                                   m_farm->async_queued[p].end(), task)
+                                       : m_farm->async_queued[0].end();
+            if (!current || queued_task == m_farm->async_queued[p].end()) {
+                if (m_context) {
+                    m_context->get_batch_stats().late_results++;
+                }
+                // A cancelled task that had already started: its process is free for another one,
+                // unless it was refilled to the full when cancelled
+                if (p >= 0) {
+                    async_dispatch();
+                }
+                continue;
+            }
+            m_farm->async_queued[p].erase(queued_task);
+            int id = task / m_runs;
+            auto& candidate = m_farm->async[id];
+            for (std::size_t k = mpi_protocol::result_header_size; k < result.size();
+                 k += mpi_protocol::result_run_size) {
+                candidate.sum += result[k];
+                candidate.n_done++;
+                if (m_context) {
+                    run_record record;
+                    record.candidate = id;
+                    record.run = task % m_runs;
+                    record.seed = candidate.seeds[record.run];
+                    record.worker = p;
+                    record.speculative = false;
+                    record.fitness = result[k];
+                    record.steps = static_cast<unsigned long>(result[k + 1]);
+                    record.seconds = result[k + 2];
+                    m_context->add_run(record);
+                }
+            }
+            // Hand the next pending task to the process that just finished
+            async_dispatch();
+            if (candidate.n_done == m_runs) {
+                candidate.in_flight = false;
+                fitness = candidate.sum / m_runs;
+                if (get_async_in_flight() == 0) {
+                    m_farm->outbox.wait_all();
+                }
+                return id;
+            }
+        }
+        return -1;
+    }
+
+    /// Cancel all the candidates in flight
+    /**
+     * The runs not dispatched yet are dropped, and the ones queued on the processes are cancelled:
+     * they are skipped if they have not started, and the results of the others are dropped as
+     * late ones by the next async_collect() or batch_fitness() call. Their runs are thus not
+     * recorded in the evaluation context and do not count against its budget.
+     */
+    void async_cancel() const {
+        m_farm->async_pending.clear();
+        for (int p = 0; p < static_cast<int>(m_farm->async_queued.size()); p++) {
+            for (int task : m_farm->async_queued[p]) {
+                if (m_farm->workers[p].alive) {
+                    cancel_task(p, task);
+                }
+            }
+            m_farm->async_queued[p].clear();
+        }
+        for (auto& candidate : m_farm->async) {
+            candidate.in_flight = false;
+        }
+        m_farm->outbox.wait_all();
+    }
+
+    /// Number of submitted candidates whose fitness is not collected yet
+    int get_async_in_flight() const {
+        return static_cast<int>(std::count_if(m_farm->async.begin(), m_farm->async.end(),
+                                              [](const mpi_farm::async_candidate& c) {
+                                                  return c.in_flight;
+                                              }));
+    }
+
+    /// Number of candidates in flight that fill the task queues of all the processes
+    int get_async_capacity() const {
+        int depth = std::max(1, std::min(m_options.prefetch, mpi_protocol::max_prefetch));
+        return (m_proc * depth + m_runs - 1) / m_runs;
+    }
+
+    /// Number of scheduler processes
+    int get_proc() const { return m_proc; }
+
+    /// Number of runs of every candidate
+    int get_runs() const { return m_runs; }
+
+    /// Sets the seed
+    /**
+     * Having this method makes the problem stochastic: pagmo::cmaes and pagmo::xnes call it with a
+     * value drawn from their own random engine before evaluating each generation.
+     *
+     * @param seed the seed the simulation seeds are drawn from.
+     */
+    void set_seed(unsigned seed) {
+        m_e.seed(seed);
+        m_seed = seed;
+    }
+
+    /// Gets the seed
+    /**
+     * @return the seed the simulation seeds are drawn from.
+     */
+    unsigned get_seed() const { return m_seed; }
+
     /// Box-bounds
     /**
      * @return the lower and upper bounds for each decision vector component.
@@ -124,6 +715,204 @@ struct mpi_thread {
         ar &m_dim; 
     }
 
+    /// Whether the common seeds are broadcast as a table, rather than sent with each task
+    /**
+     * A broadcast would block on a stuck process, so the table is not used with a task timeout.
+     */
+    bool seed_table() const { return m_options.common_seeds && m_options.task_timeout <= 0.; }
+
+    /// Seed value sent with a task
+    /**
+     * @return the seed of the task, or its index in the common seed table (see seed_table()).
+     */
+    unsigned task_seed(int task, const std::vector<unsigned>& seeds) const {
+        if (!m_options.common_seeds) {
+            return seeds[task];
+        }
+        return seed_table() ? static_cast<unsigned>(task % m_runs) : seeds[task % m_runs];
+    }
+
+    /// Send the end signal to all the scheduler processes, the replaced ones included
+    void terminate() const {
+        init_workers();
+        std::vector<char> buffer;
+        mpi_protocol::pack_task(buffer, {mpi_protocol::op_end, -1, 0, 0});
+        for (const auto& workers : {m_farm->workers, m_farm->replaced}) {
+            for (const auto& worker : workers) {
+                worker.comm.Send(buffer.data(), buffer.size(), MPI::BYTE, worker.rank,
+                                 mpi_protocol::tag_control);
+            }
+        }
+    }
+
+    /// Build the table of the scheduler processes, on first use
+    void init_workers() const {
+        if (m_farm->workers.empty()) {
+            for (int p = 0; p < m_proc; p++) {
+                m_farm->workers.push_back({m_g_com, p, false, true});
+            }
+        }
+    }
+
+    /// Stop dispatching tasks to process \p p, and spawn a new one in its place if required
+    void revoke_worker(int p) const {
+        m_farm->workers[p].alive = false;
+        if (m_options.respawn) {
+            std::cout << "Spawning a new scheduler in place of " << p << std::endl;
+            MPI::Intercomm comm = MPI::COMM_WORLD.Spawn(
+                m_options.scheduler_binary.c_str(), m_options.scheduler_argv, 1, MPI::Info(), 0);
+            m_farm->replaced.push_back(m_farm->workers[p]);
+            m_farm->workers[p] = {comm, 0, true, true};
+        }
+    }
+
+    /// Receive the results of a task
+    /**
+     * Blocks until a result arrives, unless a task timeout is set.
+     *
+     * @param result filled with the results of the runs of the task.
+     * @param task set to the task ID.
+     *
+     * @return the process the results came from, -1 if they came from a process that was revoked,
+     * -2 if nothing arrived (with a task timeout only).
+     */
+    int receive_result(vector_double& result, int& task) const {
+        MPI::Status status;
+        auto receive = [&](const MPI::Intercomm& comm) {
+            result.resize(status.Get_count(MPI::DOUBLE));
+            comm.Recv(result.data(), result.size(), MPI::DOUBLE, status.Get_source(),
+                      mpi_protocol::tag_result);
+            task = static_cast<int>(result.at(1));
+        };
+        if (m_options.task_timeout <= 0.) {
+            m_g_com.Probe(MPI::ANY_SOURCE, mpi_protocol::tag_result, status);
+            receive(m_g_com);
+            return status.Get_source();
+        }
+        if (m_g_com.Iprobe(MPI::ANY_SOURCE, mpi_protocol::tag_result, status)) {
+            receive(m_g_com);
+            for (int p = 0; p < m_proc; p++) {
+                if (!m_farm->workers[p].spawned && m_farm->workers[p].alive
+                    && m_farm->workers[p].rank == status.Get_source()) {
+                    return p;
+                }
+            }
+            return -1;
+        }
+        for (int p = 0; p < m_proc; p++) {
+            if (m_farm->workers[p].spawned && m_farm->workers[p].alive
+                && m_farm->workers[p].comm.Iprobe(0, mpi_protocol::tag_result, status)) {
+                receive(m_farm->workers[p].comm);
+                return p;
+            }
+        }
+        return -2;
+    }
+
+    /// Broadcast the common seed table of the generation to all the scheduler processes
+    void broadcast_seeds(std::vector<unsigned>& seeds) const {
+        std::vector<char> buffer;
+        mpi_protocol::pack_task(buffer, {mpi_protocol::op_seed_table, -1, 0, 0});
+        int n_seeds = seeds.size();
+        for (int p = 0; p < m_proc; p++) {
+            m_g_com.Send(buffer.data(), buffer.size(), MPI::BYTE, p, mpi_protocol::tag_control);
+        }
+        m_g_com.Bcast(&n_seeds, 1, MPI::INT, MPI::ROOT);
+        m_g_com.Bcast(seeds.data(), n_seeds, MPI::UNSIGNED, MPI::ROOT);
+    }
+
+    /// Broadcast the search distribution of the generation to all the scheduler processes
+    void broadcast_sampling_state(const sampling_state& state) const {
+        std::vector<char> buffer;
+        unsigned header[3] = {static_cast<unsigned>(m_dim), state.force_bounds, state.diagonal};
+        mpi_protocol::pack_task(buffer, {mpi_protocol::op_sampling_state, -1, 3, 0}, header);
+        for (int p = 0; p < m_proc; p++) {
+            m_g_com.Send(buffer.data(), buffer.size(), MPI::BYTE, p, mpi_protocol::tag_control);
+        }
+        std::vector<double> values = pack_sampling_state(state);
+        m_g_com.Bcast(values.data(), values.size(), MPI::DOUBLE, MPI::ROOT);
+    }
+
+    /// Publish the decision vectors of the generation in the shared matrix of every node
+    void publish_generation(const vector_double& dvs, int n_dvs) const {
+        std::vector<char> buffer;
+        unsigned sizes[2] = {static_cast<unsigned>(n_dvs), static_cast<unsigned>(m_dim)};
+        mpi_protocol::pack_task(buffer, {mpi_protocol::op_generation, -1, 2, 0}, sizes);
+        for (int p = 0; p < m_proc; p++) {
+            m_g_com.Send(buffer.data(), buffer.size(), MPI::BYTE, p, mpi_protocol::tag_control);
+        }
+        m_shared->publish(dvs.data(), n_dvs, m_dim);
+    }
+
+    /// Cancel the copy of task \p task queued on scheduler process \p p
+    void cancel_task(int p, int task) const {
+        post_task(p, {mpi_protocol::op_cancel, task, 0, 0}, nullptr, nullptr);
+    }
+
+    /// Top up the task queues of the processes with the pending asynchronous tasks
+    /**
+     * The queues are filled level by level, so that every process gets a task before any gets
+     * two.
+     */
+    void async_dispatch() const {
+        int depth = std::max(1, std::min(m_options.prefetch, mpi_protocol::max_prefetch));
+        for (int d = 1; d <= depth; d++) {
+            for (int p = 0; p < m_proc && !m_farm->async_pending.empty(); p++) {
+                if (!m_farm->workers[p].alive
+                    || static_cast<int>(m_farm->async_queued[p].size()) >= d) {
+                    continue;
+                }
+                int task = m_farm->async_pending.front();
+                m_farm->async_pending.pop_front();
+                const auto& candidate = m_farm->async[task / m_runs];
+                mpi_protocol::task_header header{mpi_protocol::op_task, task, 1, m_dim};
+                header.batch = m_farm->batch;
+                post_task(p, header, &candidate.seeds[task % m_runs], candidate.x.data());
+                m_farm->async_queued[p].push_back(task);
+            }
+        }
+    }
+
+    /// Send one evaluation task (a single simulation run) to a scheduler process
+    /**
+     * The task is packed into a buffer of mpi_farm::outbox and sent without blocking.
+     *
+     * @param p index of the scheduler process.
+     * @param task task ID, echoed back by the scheduler with the results.
+     * @param seed seed of the simulation run, or its index in the common seed table.
+     * @param x pointer to the \p m_dim weights of the candidate, not sent with a shared
+     * generation matrix.
+     * @param sampling distribution and seeds of the candidates in the seeded sampling mode, or
+     * nullptr.
+     */
+    void send_task(int p, int task, unsigned seed, const double* x,
+                   const sampling_batch* sampling) const {
+        mpi_protocol::task_header header{
+            seed_table() ? mpi_protocol::op_task_common : mpi_protocol::op_task, task, 1, 0};
+        header.batch = m_farm->batch;
+        if (sampling) {
+            header.source = mpi_protocol::weights_sampled;
+            header.sample_seed = sampling->seeds[task / m_runs];
+        } else if (m_shared) {
+            header.source = mpi_protocol::weights_shared;
+            header.candidate = task / m_runs;
+        } else {
+            header.n_weights = m_dim;
+        }
+        post_task(p, header, &seed, x);
+    }
+
+    /// Pack a message to scheduler process \p p into a buffer of mpi_farm::outbox and send it
+    /// without blocking
+    void post_task(int p, const mpi_protocol::task_header& header, const unsigned* seeds,
+                   const double* x) const {
+        const auto& worker = m_farm->workers[p];
+        auto& message = m_farm->outbox.take(p);
+        mpi_protocol::pack_task(message.buffer, header, seeds, x);
+        message.request = worker.comm.Isend(message.buffer.data(), message.buffer.size(),
+                                            MPI::BYTE, worker.rank, mpi_protocol::tag_control);
+    }
+
     /// Problem dimensions
     int m_proc;
     int m_dim;
@@ -131,6 +920,13 @@ struct mpi_thread {
     double m_lbound;
     double m_ubound;
     MPI::Intercomm m_g_com;
+    mutable detail::random_engine_type m_e;
+    unsigned m_seed;
+    mpi_options m_options;
+    eval_context* m_context;
+    mpi_shared_generation* m_shared;
+    /// Scheduler processes and dispatch state, shared by all the copies of the problem
+    std::shared_ptr<mpi_farm> m_farm;
     thread_safety m_thread_safety;
     bool m_has_batch_fitness;
 };
@@ -0,0 +1,177 @@
+/*
+ * mpi_protocol.hpp
+ *
+ * Messages exchanged between the master (mpi_thread) and the scheduler processes.
+ */
+
+#ifndef PAGMO_MPI_PROTOCOL
+#define PAGMO_MPI_PROTOCOL
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace pagmo {
+namespace mpi_protocol {
+
+/// Tag of the messages sent to a scheduler
+const int tag_control = 1;
+
+/// Tag of the result messages sent back by a scheduler
+/**
+ * The task ID is part of the message rather than its tag: MPI only guarantees tags up to 32767,
+ * fewer than the runs of a large generation.
+ */
+const int tag_result = 2;
+
+/// Opcode of a message sent to a scheduler
+enum opcode : int {
+    /// Terminate the scheduler
+    op_end = 0,
+    /// Evaluate a candidate: one seed per run, then the weights if task_header::source is
+    /// weights_sent
+    op_task = 1,
+    /// Same as op_task, but the per-run values are indices into the common seed table
+    op_task_common = 2,
+    /// A new common seed table follows as a broadcast on the intercommunicator: its size, then
+    /// the seeds
+    op_seed_table = 3,
+    /// Join the shared generation matrix (see mpi_shared_generation)
+    op_shared_setup = 4,
+    /// A new generation is published in the shared matrix (see mpi_shared_generation::publish()).
+    /// The two values following the header are the number of candidates and their dimension.
+    op_generation = 5,
+    /// A new search distribution follows as a broadcast on the intercommunicator (see
+    /// pack_sampling_state()). The three values following the header are its dimension, whether
+    /// the candidates are clamped to the bounds and whether the distribution is diagonal.
+    op_sampling_state = 6,
+    /// Skip task task_header::task if it is queued and not started yet: another process returned
+    /// it first
+    op_cancel = 7
+};
+
+/// Where the weights of the candidate of a task come from
+enum weights_source : int {
+    /// In the task message
+    weights_sent = 0,
+    /// Row task_header::candidate of the shared generation matrix
+    weights_shared = 1,
+    /// Drawn with sample_candidate() from the last search distribution and task_header::sample_seed
+    weights_sampled = 2
+};
+
+/// Largest number of runs in a task
+/**
+ * The schedulers post the receive of their next task before knowing its size: their buffer is
+ * sized for this many runs.
+ */
+const int max_task_runs = 64;
+
+/// Largest number of tasks queued on a scheduler
+/**
+ * The schedulers keep this many receives posted, so that the tasks the master sends ahead of time
+ * are delivered while they run the current one.
+ */
+const int max_prefetch = 4;
+
+/// Header of a message sent to a scheduler
+struct task_header {
+    /// One of the opcodes
+    int op;
+    /// Task ID, echoed back in the result message
+    int task;
+    /// Number of runs, i.e. of seeds following the header
+    int n_runs;
+    /// Number of weights following the seeds
+    int n_weights;
+    /// Where the weights of the candidate come from
+    int source = weights_sent;
+    /// Row of the candidate in the shared generation matrix
+    int candidate = -1;
+    /// Seed of the candidate in its search distribution
+    unsigned sample_seed = 0;
+    /// Batch of the task, echoed back first in the result message
+    unsigned batch = 0;
+};
+
+/// Size in bytes of a message with \p n_runs seeds and \p n_weights weights
+inline std::size_t task_size(int n_runs, int n_weights) {
+    return sizeof(task_header) + n_runs * sizeof(unsigned) + n_weights * sizeof(double);
+}
+
+/// Pack a message: the header, its seeds, then its weights
+/**
+ * Every message to a scheduler is a single MPI::BYTE message on tag_control, so that a task costs
+ * one send whatever its content.
+ *
+ * @param buffer the message, resized to its content.
+ * @param header the header; header.n_runs seeds and header.n_weights weights are copied.
+ * @param seeds the seeds of the runs, or their indices in the common seed table.
+ * @param weights the weights of the candidate.
+ */
+inline void pack_task(std::vector<char>& buffer, const task_header& header,
+                      const unsigned* seeds = nullptr, const double* weights = nullptr) {
+    buffer.resize(task_size(header.n_runs, header.n_weights));
+    char* p = buffer.data();
+    std::memcpy(p, &header, sizeof(task_header));
+    p += sizeof(task_header);
+    if (header.n_runs > 0) {
+        std::memcpy(p, seeds, header.n_runs * sizeof(unsigned));
+    }
+    p += header.n_runs * sizeof(unsigned);
+    if (header.n_weights > 0) {
+        std::memcpy(p, weights, header.n_weights * sizeof(double));
+    }
+}
+
+/// Unpack a message packed by pack_task()
+/**
+ * @param buffer the message.
+ * @param seeds resized and filled with the seeds of the message.
+ * @param weights resized and filled with the weights of the message.
+ *
+ * @return the header of the message.
+ */
+inline task_header unpack_task(const std::vector<char>& buffer, std::vector<unsigned>& seeds,
+                               std::vector<double>& weights) {
+    task_header header;
+    const char* p = buffer.data();
+    std::memcpy(&header, p, sizeof(task_header));
+    p += sizeof(task_header);
+    seeds.resize(header.n_runs);
+    if (header.n_runs > 0) {
+        std::memcpy(seeds.data(), p, header.n_runs * sizeof(unsigned));
+    }
+    p += header.n_runs * sizeof(unsigned);
+    weights.resize(header.n_weights);
+    if (header.n_weights > 0) {
+        std::memcpy(weights.data(), p, header.n_weights * sizeof(double));
+    }
+    return header;
+}
+
+/// Header of a message packed by pack_task(), without unpacking its payload
+inline task_header peek_task(const std::vector<char>& buffer) {
+    task_header header;
+    std::memcpy(&header, buffer.data(), sizeof(task_header));
+    return header;
+}
+
+/// Number of values per run in a result message: fitness, simulated steps and wall-clock seconds
+/**
+ * A result message is sent on tag_result and holds, as doubles, the batch and the ID of the task
+ * (see result_header_size) then these values for each run of the task.
+ */
+const int result_run_size = 3;
+
+/// Number of values before the runs in a result message: the batch and the ID of the task
+/**
+ * A task ID is only unique within its batch: the batch tells apart the late results of a task
+ * from a previous batch, such as a speculative copy that lost.
+ */
+const int result_header_size = 2;
+
+} // namespace mpi_protocol
+} // namespace pagmo
+
+#endif
@@ -0,0 +1,173 @@
+/*
+ * mpi_race.hpp
+ *
+ * Dispatch order of the runs of a batch, and the race that stops the runs of the losing
+ * candidates (see mpi_thread::batch_fitness()).
+ */
+
+#ifndef PAGMO_MPI_RACE
+#define PAGMO_MPI_RACE
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <vector>
+
+namespace pagmo {
+
+/// Runs of the candidates of a batch, in dispatch order
+/**
+ * The task ID of run \p r of candidate \p c is <tt>c * runs + r</tt>. The runs are handed out run
+ * by run: run 0 of every candidate, then run 1, and so on.
+ *
+ * With racing, only the first \p min_runs runs of every candidate are handed out up front. The
+ * further runs of a candidate are held back until \p min_runs of its runs are finished, and
+ * before handing out each of them the candidate is dropped if its confidence interval lies
+ * entirely above those of the best half of the batch, i.e. the elite of pagmo::cmaes or the
+ * positive utilities of pagmo::xnes. The race thus decides even when the processes could take
+ * all the runs of the batch at once, at the cost of leaving some of them idle while the first
+ * runs finish.
+ */
+class run_race {
+  public:
+    /// Constructor
+    /**
+     * @param n_candidates number of candidates of the batch.
+     * @param runs number of runs of every candidate.
+     * @param racing whether the losing candidates are dropped.
+     * @param min_runs number of finished runs a candidate gets before the race can drop it.
+     * @param width half-width of the confidence intervals, in standard errors.
+     */
+    run_race(int n_candidates, int runs, bool racing = false, int min_runs = 2, double width = 2.)
+        : m_runs(runs), m_racing(racing && min_runs < runs), m_min_runs(std::max(1, min_runs)),
+          m_width(width), m_n_done(n_candidates, 0), m_sum(n_candidates, 0.),
+          m_sum_sq(n_candidates, 0.), m_dropped(n_candidates, false) {
+        int n_first = m_racing ? m_min_runs : runs;
+        m_n_first = n_candidates * n_first;
+        m_next_run.assign(n_candidates, n_first);
+        m_n_held = m_racing ? n_candidates : 0;
+    }
+
+    /// Next run to dispatch
+    /**
+     * @return its task ID, or -1 if no run can be dispatched until more runs finish (see
+     * holding()) or all of them were dispatched.
+     */
+    int next() {
+        int n_candidates = m_n_done.size();
+        if (m_next < m_n_first) {
+            int c = m_next % n_candidates;
+            int r = m_next / n_candidates;
+            m_next++;
+            return c * m_runs + r;
+        }
+        while (!m_ready.empty()) {
+            int c = m_ready.front();
+            m_ready.pop_front();
+            if (lost(c)) {
+                m_dropped[c] = true;
+                m_n_skipped += m_runs - m_next_run[c];
+                continue;
+            }
+            int r = m_next_run[c]++;
+            // Round robin over the candidates that may go on
+            if (m_next_run[c] < m_runs) {
+                m_ready.push_back(c);
+            }
+            return c * m_runs + r;
+        }
+        return -1;
+    }
+
+    /// Whether some runs are held back until more runs finish
+    bool holding() const { return m_n_held > 0; }
+
+    /// Record the fitness \p f of a finished run of candidate \p c
+    void add(int c, double f) {
+        m_n_done[c]++;
+        m_sum[c] += f;
+        m_sum_sq[c] += f * f;
+        if (m_racing && m_n_done[c] == m_min_runs) {
+            m_n_held--;
+            m_ready.push_back(c);
+        }
+    }
+
+    /// Number of finished runs of candidate \p c
+    int get_done(int c) const { return m_n_done[c]; }
+
+    /// Mean fitness of the finished runs of candidate \p c, 0 if there is none
+    double get_mean(int c) const { return m_n_done[c] > 0 ? m_sum[c] / m_n_done[c] : 0.; }
+
+    /// Whether candidate \p c was dropped by the race
+    bool is_dropped(int c) const { return m_dropped[c]; }
+
+    /// Number of runs the race skipped
+    int get_skipped() const { return m_n_skipped; }
+
+    /// Whether candidate \p c lost the race
+    /**
+     * The noise of a run is assumed to be the same for all the candidates, so its variance is
+     * pooled over all of them. A candidate is only bounded once \p min_runs of its runs are
+     * finished.
+     *
+     * @return true if at least half of the batch is certainly better than \p c.
+     */
+    bool lost(int c) const {
+        int n_candidates = m_n_done.size();
+        if (m_n_done[c] == 0 || m_n_done[c] < m_min_runs) {
+            return false;
+        }
+        double ss = 0.;
+        int dof = 0;
+        for (int i = 0; i < n_candidates; i++) {
+            if (m_n_done[i] > 1) {
+                ss += m_sum_sq[i] - m_sum[i] * m_sum[i] / m_n_done[i];
+                dof += m_n_done[i] - 1;
+            }
+        }
+        if (dof == 0) {
+            return false;
+        }
+        double sd = std::sqrt(std::max(0., ss / dof));
+
+        // Pessimistic (upper) bounds of the other candidates
+        std::vector<double> upper;
+        for (int i = 0; i < n_candidates; i++) {
+            if (i != c && m_n_done[i] > 0) {
+                upper.push_back(get_mean(i) + m_width * sd / std::sqrt(m_n_done[i]));
+            }
+        }
+        std::size_t n_elite = (n_candidates + 1) / 2;
+        if (upper.size() < n_elite) {
+            return false;
+        }
+        std::nth_element(upper.begin(), upper.begin() + (n_elite - 1), upper.end());
+        double lower = get_mean(c) - m_width * sd / std::sqrt(m_n_done[c]);
+        return lower > upper[n_elite - 1];
+    }
+
+  private:
+    int m_runs;
+    bool m_racing;
+    int m_min_runs;
+    double m_width;
+    /// Runs handed out up front, in run-major order, and the next of them
+    int m_n_first;
+    int m_next = 0;
+    /// Candidates whose further runs are held back, and those that may go on, in turn
+    int m_n_held;
+    std::deque<int> m_ready;
+    /// Next run of each candidate
+    std::vector<int> m_next_run;
+    /// Statistics of the finished runs of each candidate
+    std::vector<int> m_n_done;
+    std::vector<double> m_sum;
+    std::vector<double> m_sum_sq;
+    std::vector<bool> m_dropped;
+    int m_n_skipped = 0;
+};
+
+} // namespace pagmo
+
+#endif
@@ -0,0 +1,125 @@
+/*
+ * mpi_shared.hpp
+ *
+ * Generation matrix shared by the processes of each node through an MPI-3 shared-memory window.
+ */
+
+#ifndef PAGMO_MPI_SHARED
+#define PAGMO_MPI_SHARED
+
+#include <cstddef>
+#include <cstring>
+#include <mpi.h>
+
+namespace pagmo {
+
+/// Decision vectors of a generation, published once per node
+/**
+ * The master and the schedulers merge their intercommunicator and split it by node. On each node,
+ * the process of lowest rank (the master on its own node) allocates a shared-memory window that
+ * the other processes of the node map. At every generation, the master sends the whole matrix of
+ * decision vectors once to each node leader, which copies it into the window of its node: the
+ * tasks then only carry the row of their candidate instead of its weights.
+ *
+ * All the methods except row() are collective over the master and all the schedulers: the
+ * master sends mpi_protocol::op_shared_setup (constructor) or mpi_protocol::op_generation
+ * (publish()) to the schedulers before calling them.
+ */
+class mpi_shared_generation {
+  public:
+    /// Constructor
+    /**
+     * @param comm intercommunicator between the master and the schedulers.
+     * @param scheduler false on the master, true on the schedulers.
+     */
+    mpi_shared_generation(MPI_Comm comm, bool scheduler)
+        : m_win(MPI_WIN_NULL), m_base(nullptr), m_capacity(0), m_dim(0) {
+        MPI_Intercomm_merge(comm, scheduler, &m_all);
+        int rank;
+        MPI_Comm_rank(m_all, &rank);
+        MPI_Comm_split_type(m_all, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &m_node);
+        MPI_Comm_rank(m_node, &m_node_rank);
+        // The master has rank 0 in m_all, hence in its node and among the leaders
+        MPI_Comm_split(m_all, m_node_rank == 0 ? 0 : MPI_UNDEFINED, rank, &m_leaders);
+    }
+
+    /// Destructor: collective, must be called before MPI_Finalize
+    ~mpi_shared_generation() {
+        free_window();
+        if (m_leaders != MPI_COMM_NULL) {
+            MPI_Comm_free(&m_leaders);
+        }
+        MPI_Comm_free(&m_node);
+        MPI_Comm_free(&m_all);
+    }
+
+    mpi_shared_generation(const mpi_shared_generation&) = delete;
+    mpi_shared_generation& operator=(const mpi_shared_generation&) = delete;
+
+    /// Publish the decision vectors of a generation on every node
+    /**
+     * The window is reallocated when the generation is larger than any previous one.
+     *
+     * @param dvs the \p n_dvs decision vectors, stored contiguously (master only, ignored on the
+     * schedulers).
+     * @param n_dvs number of decision vectors.
+     * @param dim dimension of the decision vectors.
+     */
+    void publish(const double* dvs, int n_dvs, int dim) {
+        std::size_t size = static_cast<std::size_t>(n_dvs) * dim;
+        if (size > m_capacity) {
+            allocate(size);
+        }
+        m_dim = dim;
+        if (m_leaders != MPI_COMM_NULL) {
+            if (dvs != nullptr) {
+                std::memcpy(m_base, dvs, size * sizeof(double));
+            }
+            MPI_Bcast(m_base, static_cast<int>(size), MPI_DOUBLE, 0, m_leaders);
+        }
+        // Make the copy of the leader visible to the other processes of the node
+        MPI_Win_sync(m_win);
+        MPI_Barrier(m_node);
+        MPI_Win_sync(m_win);
+    }
+
+    /// Decision vector of candidate \p c of the last published generation
+    double* row(int c) const { return m_base + static_cast<std::size_t>(c) * m_dim; }
+
+    /// Dimension of the decision vectors of the last published generation
+    int get_dim() const { return m_dim; }
+
+  private:
+    /// (Re)allocate the window of the node for \p size doubles
+    void allocate(std::size_t size) {
+        free_window();
+        double* base;
+        MPI_Aint local_size = m_node_rank == 0 ? size * sizeof(double) : 0;
+        MPI_Win_allocate_shared(local_size, sizeof(double), MPI_INFO_NULL, m_node, &base, &m_win);
+        MPI_Aint leader_size;
+        int disp_unit;
+        MPI_Win_shared_query(m_win, 0, &leader_size, &disp_unit, &m_base);
+        MPI_Win_lock_all(MPI_MODE_NOCHECK, m_win);
+        m_capacity = size;
+    }
+
+    void free_window() {
+        if (m_win != MPI_WIN_NULL) {
+            MPI_Win_unlock_all(m_win);
+            MPI_Win_free(&m_win);
+        }
+    }
+
+    MPI_Comm m_all;
+    MPI_Comm m_node;
+    MPI_Comm m_leaders;
+    int m_node_rank;
+    MPI_Win m_win;
+    double* m_base;
+    std::size_t m_capacity;
+    int m_dim;
+};
+
+} // namespace pagmo
+
+#endif
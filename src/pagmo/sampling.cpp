@@ -0,0 +1,93 @@
+#include "sampling.hpp"
+
+#include <cmath>
+#include <cstdint>
+
+namespace pagmo {
+
+namespace {
+
+// SplitMix64 finaliser: a bijection of 64-bit integers with good avalanche
+std::uint64_t mix(std::uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Uniform double in (0, 1] from the 53 high bits
+double uniform(std::uint64_t bits) {
+    return static_cast<double>((bits >> 11) + 1) * (1. / 9007199254740992.);
+}
+
+} // namespace
+
+void sample_normal(unsigned seed, Eigen::VectorXd& z) {
+    const double two_pi = 6.283185307179586476925286766559;
+    const std::uint64_t gamma = 0x9e3779b97f4a7c15ULL;
+    std::uint64_t key = mix(static_cast<std::uint64_t>(seed) * gamma + gamma);
+    for (Eigen::Index i = 0; i < z.size(); i += 2) {
+        // One pair of normal numbers per counter value
+        std::uint64_t counter = key + static_cast<std::uint64_t>(i / 2 + 1) * gamma;
+        double u1 = uniform(mix(counter));
+        double u2 = uniform(mix(counter ^ key));
+        double r = std::sqrt(-2. * std::log(u1));
+        z(i) = r * std::cos(two_pi * u2);
+        if (i + 1 < z.size()) {
+            z(i + 1) = r * std::sin(two_pi * u2);
+        }
+    }
+}
+
+void sample_candidate(const sampling_state& state, unsigned seed, Eigen::VectorXd& z,
+                      Eigen::VectorXd& x) {
+    z.resize(state.mean.size());
+    sample_normal(seed, z);
+    if (state.diagonal) {
+        x = state.mean + state.scale.cwiseProduct(z);
+    } else {
+        x.noalias() = state.transform * z;
+        x += state.mean;
+    }
+    if (state.force_bounds) {
+        x = x.cwiseMax(state.lb).cwiseMin(state.ub);
+    }
+}
+
+std::size_t packed_sampling_size(int dim, bool diagonal) {
+    std::size_t n = dim;
+    return diagonal ? 4 * n : n * (n + 3);
+}
+
+std::vector<double> pack_sampling_state(const sampling_state& state) {
+    Eigen::Index dim = state.mean.size();
+    Eigen::Index scale_size = state.diagonal ? dim : dim * dim;
+    std::vector<double> values(packed_sampling_size(dim, state.diagonal));
+    Eigen::Map<Eigen::VectorXd>(values.data(), dim) = state.mean;
+    if (state.diagonal) {
+        Eigen::Map<Eigen::VectorXd>(values.data() + dim, dim) = state.scale;
+    } else {
+        Eigen::Map<Eigen::MatrixXd>(values.data() + dim, dim, dim) = state.transform;
+    }
+    Eigen::Map<Eigen::VectorXd>(values.data() + dim + scale_size, dim) = state.lb;
+    Eigen::Map<Eigen::VectorXd>(values.data() + 2 * dim + scale_size, dim) = state.ub;
+    return values;
+}
+
+sampling_state unpack_sampling_state(const std::vector<double>& values, int dim, bool diagonal,
+                                     bool force_bounds) {
+    Eigen::Index scale_size = diagonal ? dim : Eigen::Index(dim) * dim;
+    sampling_state state;
+    state.mean = Eigen::Map<const Eigen::VectorXd>(values.data(), dim);
+    state.diagonal = diagonal;
+    if (diagonal) {
+        state.scale = Eigen::Map<const Eigen::VectorXd>(values.data() + dim, dim);
+    } else {
+        state.transform = Eigen::Map<const Eigen::MatrixXd>(values.data() + dim, dim, dim);
+    }
+    state.force_bounds = force_bounds;
+    state.lb = Eigen::Map<const Eigen::VectorXd>(values.data() + dim + scale_size, dim);
+    state.ub = Eigen::Map<const Eigen::VectorXd>(values.data() + 2 * dim + scale_size, dim);
+    return state;
+}
+
+} // namespace pagmo
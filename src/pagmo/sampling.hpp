@@ -0,0 +1,64 @@
+#ifndef PAGMO_SAMPLING_HPP
+#define PAGMO_SAMPLING_HPP
+
+#include <Eigen/Dense>
+#include <cstddef>
+#include <vector>
+
+namespace pagmo {
+
+/// Search distribution of a generation
+/**
+ * A candidate is <tt>mean + transform * z</tt> with \p z a standard normal vector, clamped to the
+ * bounds if \p force_bounds is set: \p transform is <tt>sigma * B * D</tt> for pagmo::cmaes and
+ * \p A for pagmo::xnes. The distributions of the separable pagmo::cmaes and of pagmo::snes are
+ * \p diagonal: the candidate is then <tt>mean + scale .* z</tt> and \p transform is not used, so
+ * that only the N step-sizes are sent to the schedulers instead of an N x N matrix.
+ */
+struct sampling_state {
+    Eigen::VectorXd mean;
+    Eigen::MatrixXd transform;
+    bool diagonal = false;
+    Eigen::VectorXd scale;
+    bool force_bounds = false;
+    Eigen::VectorXd lb;
+    Eigen::VectorXd ub;
+};
+
+/// Standard normal vector of a candidate
+/**
+ * The components are drawn from a counter-based generator keyed by \p seed (Box-Muller on a
+ * hashed counter), so that any process can rebuild the vector from the seed alone.
+ *
+ * @param seed seed of the candidate.
+ * @param z filled with a standard normal vector, of its current size.
+ */
+void sample_normal(unsigned seed, Eigen::VectorXd& z);
+
+/// Candidate drawn from a search distribution
+/**
+ * This is the only place where the candidates are computed in the seeded sampling mode, by the
+ * algorithms on the master and by the schedulers alike: the decision vector a scheduler rebuilds
+ * is bitwise identical to the one the algorithm evaluates.
+ *
+ * @param state the search distribution.
+ * @param seed seed of the candidate.
+ * @param z resized and filled with the standard normal vector of the candidate.
+ * @param x resized and filled with the candidate.
+ */
+void sample_candidate(const sampling_state& state, unsigned seed, Eigen::VectorXd& z,
+                      Eigen::VectorXd& x);
+
+/// Number of values of a search distribution flattened by pack_sampling_state()
+std::size_t packed_sampling_size(int dim, bool diagonal);
+
+/// Flatten a search distribution: mean, transform (column-major) or scale, lower and upper bounds
+std::vector<double> pack_sampling_state(const sampling_state& state);
+
+/// Rebuild a search distribution flattened by pack_sampling_state()
+sampling_state unpack_sampling_state(const std::vector<double>& values, int dim, bool diagonal,
+                                     bool force_bounds);
+
+} // namespace pagmo
+
+#endif
@@ -2,6 +2,8 @@
 #include <mpi.h>
 
 // Standard C++ Library
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <math.h>
 #include <sstream>
@@ -28,13 +30,18 @@
 #include <argos3/demiurge/loop-functions/RVRCoreLoopFunctions.h>
 
 // pagmo
+#include "../pagmo/checkpoint.hpp"
 #include "../pagmo/mylogger.hpp"
 #include "../pagmo/problems/mpi_argos.hpp"
 
+#include "../pagmo/algorithms/async_cmaes.hpp"
 #include "../pagmo/algorithms/cmaes.hpp"
+#include "../pagmo/algorithms/lmmaes.hpp"
+#include "../pagmo/algorithms/restart.hpp"
+#include "../pagmo/algorithms/snes.hpp"
 #include "../pagmo/algorithms/xnes.hpp"
-/* #include <pagmo/bfe.hpp> */
 #include <pagmo/batch_evaluators/member_bfe.hpp>
+#include <pagmo/bfe.hpp>
 #include <pagmo/island.hpp>
 
 /* using namespace pagmo; */
@@ -82,22 +89,156 @@ void load_params(const char* filename) {
     paramFile >> curword;
     paramFile >> NEAT::use_cmaes;
 
+    // Optional parameters, given as "name value" pairs after the mandatory ones
+    while (paramFile >> curword) {
+        if (strcmp(curword, "common_random_numbers") == 0) {
+            paramFile >> NEAT::common_random_numbers;
+        } else if (strcmp(curword, "racing") == 0) {
+            paramFile >> NEAT::racing;
+        } else if (strcmp(curword, "racing_min_runs") == 0) {
+            paramFile >> NEAT::racing_min_runs;
+        } else if (strcmp(curword, "racing_width") == 0) {
+            paramFile >> NEAT::racing_width;
+        } else if (strcmp(curword, "prefetch") == 0) {
+            paramFile >> NEAT::prefetch;
+        } else if (strcmp(curword, "shared_memory") == 0) {
+            paramFile >> NEAT::shared_memory;
+        } else if (strcmp(curword, "seeded_sampling") == 0) {
+            paramFile >> NEAT::seeded_sampling;
+        } else if (strcmp(curword, "task_timeout") == 0) {
+            paramFile >> NEAT::task_timeout;
+        } else if (strcmp(curword, "respawn") == 0) {
+            paramFile >> NEAT::respawn;
+        } else if (strcmp(curword, "speculation") == 0) {
+            paramFile >> NEAT::speculation;
+        } else if (strcmp(curword, "async_batch") == 0) {
+            paramFile >> NEAT::async_batch;
+        } else if (strcmp(curword, "checkpoint_generations") == 0) {
+            paramFile >> NEAT::checkpoint_generations;
+        } else if (strcmp(curword, "checkpoint_minutes") == 0) {
+            paramFile >> NEAT::checkpoint_minutes;
+        } else if (strcmp(curword, "restarts") == 0) {
+            paramFile >> NEAT::restarts;
+        } else if (strcmp(curword, "separable") == 0) {
+            paramFile >> NEAT::separable;
+        } else if (strcmp(curword, "lmmaes") == 0) {
+            paramFile >> NEAT::use_lmmaes;
+        } else if (strcmp(curword, "lmmaes_vectors") == 0) {
+            paramFile >> NEAT::lmmaes_vectors;
+        } else if (strcmp(curword, "snes") == 0) {
+            paramFile >> NEAT::use_snes;
+        } else if (strcmp(curword, "single_precision") == 0) {
+            paramFile >> NEAT::single_precision;
+        } else {
+            std::cerr << "Unknown parameter " << curword << " ignored" << std::endl;
+            paramFile >> curword;
+        }
+    }
+
+    // LM-MA-ES replaces the other algorithms, and has no dense matrix to broadcast
+    if (NEAT::use_lmmaes && (NEAT::async_batch > 0 || NEAT::separable || NEAT::seeded_sampling)) {
+        std::cerr << "lmmaes disables async_batch, separable and seeded_sampling" << std::endl;
+        NEAT::async_batch = 0;
+        NEAT::separable = false;
+        NEAT::seeded_sampling = false;
+    }
+
+    // Their broadcasts would block on a stuck scheduler
+    if (NEAT::task_timeout > 0 && (NEAT::shared_memory || NEAT::seeded_sampling)) {
+        std::cerr << "task_timeout disables shared_memory and seeded_sampling" << std::endl;
+        NEAT::shared_memory = false;
+        NEAT::seeded_sampling = false;
+    }
+
+    // The asynchronous CMA-ES sends the weights with each task
+    if (NEAT::async_batch > 0 && (NEAT::shared_memory || NEAT::seeded_sampling)) {
+        std::cerr << "async_batch disables shared_memory and seeded_sampling" << std::endl;
+        NEAT::shared_memory = false;
+        NEAT::seeded_sampling = false;
+    }
+
+    // The steady-state algorithm has no generations to restart
+    if (NEAT::restarts > 0 && NEAT::use_cmaes && NEAT::async_batch > 0) {
+        std::cerr << "async_batch disables restarts" << std::endl;
+        NEAT::restarts = 0;
+    }
+
+    // Only the generational CMA-ES has a separable variant
+    if (NEAT::separable && !(NEAT::use_cmaes && NEAT::async_batch == 0)) {
+        std::cerr << "separable only applies to the generational CMA-ES" << std::endl;
+        NEAT::separable = false;
+    }
+
+    // SNES is the separable member of the xNES family
+    if (NEAT::use_snes && (NEAT::use_cmaes || NEAT::use_lmmaes)) {
+        std::cerr << "snes only applies to xNES (cmaes 0)" << std::endl;
+        NEAT::use_snes = false;
+    }
+
+    // The other algorithms keep no N x N matrix
+    if (NEAT::single_precision
+        && (NEAT::use_lmmaes || NEAT::use_snes || (NEAT::use_cmaes && NEAT::async_batch > 0))) {
+        std::cerr << "single_precision only applies to the generational CMA-ES and to xNES"
+                  << std::endl;
+        NEAT::single_precision = false;
+    }
+
+    // A checkpoint would only hold the current restart
+    if (NEAT::restarts > 0 && (NEAT::checkpoint_generations > 0 || NEAT::checkpoint_minutes > 0)) {
+        std::cerr << "restarts disable checkpoint_generations and checkpoint_minutes" << std::endl;
+        NEAT::checkpoint_generations = 0;
+        NEAT::checkpoint_minutes = 0;
+    }
+
     std::cout << "pop_size: " << NEAT::pop_size << std::endl;
     std::cout << "budget: " << NEAT::budget << std::endl;
     std::cout << "num_runs_per_gen: " << NEAT::num_runs_per_gen << std::endl;
     std::cout << "weight_lower_bound: " << NEAT::weight_lower_bound << std::endl;
     std::cout << "weight_upper_bound: " << NEAT::weight_upper_bound << std::endl;
     std::cout << "step_size: " << NEAT::step_size << std::endl;
+    std::cout << "common_random_numbers: " << NEAT::common_random_numbers << std::endl;
+    std::cout << "racing: " << NEAT::racing << std::endl;
+    std::cout << "prefetch: " << NEAT::prefetch << std::endl;
+    std::cout << "shared_memory: " << NEAT::shared_memory << std::endl;
+    std::cout << "seeded_sampling: " << NEAT::seeded_sampling << std::endl;
+    std::cout << "task_timeout: " << NEAT::task_timeout << std::endl;
+    std::cout << "respawn: " << NEAT::respawn << std::endl;
+    std::cout << "speculation: " << NEAT::speculation << std::endl;
+    std::cout << "async_batch: " << NEAT::async_batch << std::endl;
+    std::cout << "checkpoint_generations: " << NEAT::checkpoint_generations << std::endl;
+    std::cout << "checkpoint_minutes: " << NEAT::checkpoint_minutes << std::endl;
+    std::cout << "restarts: " << NEAT::restarts << std::endl;
+    std::cout << "separable: " << NEAT::separable << std::endl;
+    std::cout << "lmmaes: " << NEAT::use_lmmaes << std::endl;
+    std::cout << "lmmaes_vectors: " << NEAT::lmmaes_vectors << std::endl;
+    std::cout << "snes: " << NEAT::use_snes << std::endl;
+    std::cout << "single_precision: " << NEAT::single_precision << std::endl;
 
     paramFile.close();
 }
 
+/**
+ * Restore the algorithm and the population of a checkpoint
+ */
+population load_checkpoint(checkpoint& cp, const std::string& path, algorithm& algo,
+                           const problem& prob, unsigned seed) {
+    population pop{prob, 0u, seed};
+    if (auto* acm = algo.extract<async_cmaes>()) {
+        cp.load(path, *acm, pop);
+    } else if (!visit_es(algo, [&](auto& uda) { cp.load(path, uda, pop); })) {
+        throw std::runtime_error("Runs with restarts cannot be resumed");
+    }
+    return pop;
+}
+
 const std::string ExplainParameters() {
     std::string strExplanation = "The possible parameters are: \n\n"
                                  " -g \t start genome file for the robots \n"
                                  " -m \t nb cores to start MPI with\n"
                                  " -b \t path of the scheduler binary\n"
-                                 " -p \t the parameter file for optim algorithm\n";
+                                 " -p \t the parameter file for optim algorithm\n"
+                                 " -s \t seed of the run (random if 0 or not given)\n"
+                                 " -r \t checkpoint file to resume the run from\n";
     return strExplanation;
 }
 
@@ -110,6 +251,8 @@ int main(int argc, char* argv[]) {
     std::string unBinaries;
     std::string unParameters;
     UInt32 num_para_proc;
+    UInt32 unSeed = 0;
+    std::string unResume;
     CARGoSCommandLineArgParser cACLAP;
     cACLAP.AddArgument<std::string>('g', "genome", "genome file for your robots", unGenome);
     cACLAP.AddArgument<UInt32>('m', "nbcores", "number of parallel processes", num_para_proc);
@@ -118,6 +261,8 @@ int main(int argc, char* argv[]) {
     cACLAP.AddArgument<std::string>('p', "parameter file",
                                     "Files containing parameters for XNES/CMA-ES algorithm",
                                     unParameters);
+    cACLAP.AddArgument<UInt32>('s', "seed", "seed of the run, random if 0", unSeed);
+    cACLAP.AddArgument<std::string>('r', "resume", "checkpoint to resume the run from", unResume);
 
     std::string configFile = cACLAP.GetExperimentConfigFile();
 
@@ -134,14 +279,29 @@ int main(int argc, char* argv[]) {
 
         long unsigned int lambda = NEAT::pop_size;
 
-        if (lambda < num_para_proc) {
-            num_para_proc = lambda;
+        // Every run of every candidate is a separate task, so there is no use for more
+        // processes than lambda * num_runs_per_gen.
+        if (lambda * NEAT::num_runs_per_gen < num_para_proc) {
+            num_para_proc = lambda * NEAT::num_runs_per_gen;
         }
 
         // Spawns a number of identical binaries.
         MPI::Intercomm g_com = MPI::COMM_WORLD.Spawn(unBinaries.c_str(), (const char**)argv,
                                                      num_para_proc, MPI::Info(), 0);
 
+        // The weights of each generation are published once per node instead of being sent
+        // with every task.
+        mpi_shared_generation* shared = nullptr;
+        if (NEAT::shared_memory) {
+            std::vector<char> setup_msg;
+            mpi_protocol::pack_task(setup_msg, {mpi_protocol::op_shared_setup, -1, 0, 0});
+            for (long unsigned int j = 0; (j < num_para_proc); j++) {
+                g_com.Send(setup_msg.data(), setup_msg.size(), MPI::BYTE, j,
+                           mpi_protocol::tag_control);
+            }
+            shared = new mpi_shared_generation(g_com, false);
+        }
+
         // Get number of links
         NEAT::Genome* startgen = NEAT::Genome::new_Genome_load(unGenome.c_str());
         std::vector<NEAT::Link*> links = startgen->genesis(startgen->genome_id)->getlinks();
@@ -158,40 +318,123 @@ int main(int argc, char* argv[]) {
         int budget = NEAT::budget;
         int num_runs_per_gen = NEAT::num_runs_per_gen;
 
-        int generations = budget / num_runs_per_gen / lambda;
-
-        generations -= 1;
+        // The algorithms stop when the budget of runs is spent, counting the runs actually
+        // performed: with racing a candidate can get as few as racing_min_runs runs, so this is
+        // only an upper bound on the number of generations.
+        mpi_options options;
+        options.common_seeds = NEAT::common_random_numbers;
+        options.racing = NEAT::racing;
+        options.race_min_runs =
+            std::max(1u, std::min(NEAT::racing_min_runs, NEAT::num_runs_per_gen));
+        options.race_width = NEAT::racing_width;
+        options.prefetch = NEAT::prefetch;
+        options.task_timeout = NEAT::task_timeout;
+        options.respawn = NEAT::respawn;
+        options.speculation = NEAT::speculation;
+        options.scheduler_binary = unBinaries;
+        options.scheduler_argv = (const char**)argv;
+        eval_context context(budget);
+        context.set_seeded_sampling(NEAT::seeded_sampling);
+
+        int generations =
+            budget / (options.racing ? options.race_min_runs : num_runs_per_gen) / lambda;
 
         double lbound = NEAT::weight_lower_bound;
         double ubound = NEAT::weight_upper_bound;
 
         double step_size = NEAT::step_size;
 
-        problem prob{mpi_thread(num_para_proc, dim, num_runs_per_gen, lbound, ubound, g_com)};
+        // The algorithm, the initial population and the simulation seeds all derive from
+        // this seed, so that a run can be replayed.
+        unsigned seed = unSeed != 0 ? unSeed : pagmo::random_device::next();
+        std::cout << "seed: " << seed << std::endl;
+
+        problem prob{mpi_thread(num_para_proc, dim, num_runs_per_gen, lbound, ubound, g_com, seed,
+                                options, &context, shared)};
         member_bfe memb;
         algorithm* algo;
         logger* mylogger = new logger(true, startgen);
 
+        // The state of the run is saved to checkpoint.bin, from which it can be resumed with -r
+        checkpoint cp("checkpoint.bin", NEAT::checkpoint_generations, NEAT::checkpoint_minutes,
+                      &context, mylogger);
+
         bool force_bound = true;
         if (step_size <= 0.0) {
             force_bound = false;
             step_size = -step_size;
         }
 
-        if (NEAT::use_cmaes) {
+        // Each generation is dispatched to all the schedulers at once through
+        // mpi_thread::batch_fitness instead of one candidate at a time.
+        if (NEAT::use_lmmaes) {
+            // O(m N) per candidate, for genomes too large for a covariance matrix
+            std::cout << "LM-MA-ES algorithm started" << std::endl;
+            lmmaes lm_uda(generations, NEAT::lmmaes_vectors, step_size, 1e-6, 1e-6, false,
+                          force_bound, mylogger, seed);
+            lm_uda.set_bfe(bfe{memb});
+            lm_uda.set_eval_context(&context);
+            lm_uda.set_checkpoint(&cp);
+            algo = new algorithm{lm_uda};
+        } else if (NEAT::use_cmaes && NEAT::async_batch > 0) {
+            // Updated every async_batch finished candidates, without waiting for a generation
+            std::cout << "Asynchronous CMA-ES algorithm started" << std::endl;
+            async_cmaes acm_uda(generations, NEAT::async_batch, step_size, 1e-6, 1e-6, force_bound,
+                                mylogger, seed);
+            acm_uda.set_eval_context(&context);
+            acm_uda.set_checkpoint(&cp);
+            algo = new algorithm{acm_uda};
+        } else if (NEAT::use_cmaes) {
             std::cout << "CMA-ES algorithm started" << std::endl;
-            algorithm* cm = new algorithm{cmaes(generations, -1, -1, -1, -1, step_size, 1e-6, 1e-6,
-                                                false, force_bound, mylogger)};
-            algo = cm;
+            // The covariance matrix in the precision of the parameter file
+            auto make_cmaes = [&](auto precision) {
+                cmaes_t<decltype(precision)> cm_uda(generations, -1, -1, -1, -1, step_size, 1e-6,
+                                                    1e-6, false, force_bound, mylogger, seed);
+                cm_uda.set_bfe(bfe{memb});
+                cm_uda.set_eval_context(&context);
+                cm_uda.set_checkpoint(&cp);
+                cm_uda.set_separable(NEAT::separable);
+                return new algorithm{cm_uda};
+            };
+            algo = NEAT::single_precision ? make_cmaes(float{}) : make_cmaes(double{});
+        } else if (NEAT::use_snes) {
+            // O(N) per generation instead of the matrix exponential of xNES
+            std::cout << "SNES algorithm started" << std::endl;
+            snes sn_uda(generations, -1, -1, step_size, 1e-6, 1e-6, false, force_bound, mylogger,
+                        seed);
+            sn_uda.set_bfe(bfe{memb});
+            sn_uda.set_eval_context(&context);
+            sn_uda.set_checkpoint(&cp);
+            algo = new algorithm{sn_uda};
         } else {
             std::cout << "XNES algorithm started" << std::endl;
-            algorithm* xn = new algorithm{
-                xnes(generations, -1, -1, -1, step_size, 1e-6, 1e-6, false, force_bound, mylogger)};
-            algo = xn;
+            // The matrix A in the precision of the parameter file
+            auto make_xnes = [&](auto precision) {
+                xnes_t<decltype(precision)> xn_uda(generations, -1, -1, -1, step_size, 1e-6, 1e-6,
+                                                   false, force_bound, mylogger, seed);
+                xn_uda.set_bfe(bfe{memb});
+                xn_uda.set_eval_context(&context);
+                xn_uda.set_checkpoint(&cp);
+                return new algorithm{xn_uda};
+            };
+            algo = NEAT::single_precision ? make_xnes(float{}) : make_xnes(double{});
+        }
+
+        // The algorithm is started again from larger populations until the budget is spent
+        if (NEAT::restarts > 0) {
+            std::cout << (NEAT::restarts == 2 ? "BIPOP" : "IPOP") << " restarts" << std::endl;
+            restart rs_uda(*algo, NEAT::restarts == 2, 1000u, mylogger, seed);
+            rs_uda.set_bfe(bfe{memb});
+            rs_uda.set_eval_context(&context);
+            delete algo;
+            algo = new algorithm{rs_uda};
         }
         algo->set_verbosity(1);
 
-        island isl{*algo, prob, memb, lambda};
+        // A resumed run starts from the saved population, which is not evaluated again
+        island isl = unResume.empty()
+                         ? island{*algo, prob, memb, lambda, seed}
+                         : island{*algo, load_checkpoint(cp, unResume, *algo, prob, seed)};
 
         isl.evolve();
         isl.wait();
@@ -203,12 +446,11 @@ int main(int argc, char* argv[]) {
         const char* file_best = "best_seen.txt";
         print_cadidate_gen(pop.champion_x(), pop.champion_f()[0], startgen, file_best);
 
-        // Sends a signal to terminate the children.
+        // Sends a signal to terminate the children, including the ones spawned in place of
+        // stuck processes, which only the problem of the final population knows about.
         std::cout << "Parent: Terminate children" << std::endl;
-        bool cont = false;
-        for (long unsigned int j = 0; (j < num_para_proc); j++) {
-            g_com.Send(&cont, 1, MPI::BOOL, j, 1);
-        }
+        pop.get_problem().extract<mpi_thread>()->terminate();
+        delete shared;
 
         // Terminates MPI execution environment.
         MPI_Finalize();
@@ -2,6 +2,10 @@
 #include <mpi.h>
 
 // Standard C++ Library
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <memory>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -22,6 +26,11 @@
 // Loop function
 #include <argos3/demiurge/loop-functions/RVRCoreLoopFunctions.h>
 
+// Messages exchanged with the parent
+#include "../pagmo/problems/mpi_protocol.hpp"
+#include "../pagmo/problems/mpi_shared.hpp"
+#include "../pagmo/sampling.hpp"
+
 // isnan function
 #include <math.h>
 
@@ -49,6 +58,8 @@ int main(int argc, char* argv[]) {
     std::string unBinaries;
     std::string unParameters;
     UInt32 num_para_proc;
+    UInt32 unSeed;
+    std::string unResume;
     CARGoSCommandLineArgParser cACLAP;
     cACLAP.AddArgument<std::string>('g', "genome", "genome file for your robots", unGenome);
     cACLAP.AddArgument<UInt32>('m', "nbcores", "number of parallel processes", num_para_proc);
@@ -56,6 +67,8 @@ int main(int argc, char* argv[]) {
                                     "binaries to parallelise for objective function", unBinaries);
     cACLAP.AddArgument<std::string>(
         'p', "parameter file", "Files containing parameters for CMA-ES algorithm", unParameters);
+    cACLAP.AddArgument<UInt32>('s', "seed", "seed of the run, random if 0", unSeed);
+    cACLAP.AddArgument<std::string>('r', "resume", "checkpoint to resume the run from", unResume);
 
     cACLAP.Parse(argc - 1, argv + 1);
 
@@ -66,14 +79,42 @@ int main(int argc, char* argv[]) {
     cSimulator.LoadExperiment();
     static auto& cLoopFunctions = dynamic_cast<RVRCoreLoopFunctions&>(cSimulator.GetLoopFunctions());
 
-    // Initialization random seed
-    unsigned int g_unRandomSeed = 1;
-    time_t t;
-    srand((unsigned)time(&t));
-    g_unRandomSeed = rand();
-    argos::CRandom::CreateCategory("cmaes", g_unRandomSeed);
+    // Seeds of the runs, given by the parent with each task
     std::vector<UInt32> vecRandomSeed;
-    argos::CRandom::CRNG* pRNG = argos::CRandom::CreateRNG("cmaes");
+    // Seeds shared by all the candidates of a generation (common random numbers)
+    std::vector<UInt32> vecCommonSeed;
+    // Weights of the candidate
+    std::vector<double> vecWeights;
+    // Generation matrix shared by the processes of the node, if the parent set it up
+    std::unique_ptr<pagmo::mpi_shared_generation> pcSharedGeneration;
+    // Search distribution of the generation, and the candidate drawn from it
+    pagmo::sampling_state sSamplingState;
+    Eigen::VectorXd cSampleZ;
+    Eigen::VectorXd cSampleX;
+
+    // Current message from the parent, and the receives posted for the next ones. The parent
+    // keeps a few tasks queued on each process: their receives are posted before running the
+    // simulations of the current task, so that they are delivered in the meantime and the next
+    // simulation starts as soon as the current one ends.
+    std::vector<char> vecTask;
+    std::deque<std::vector<char>> deqNextTask;
+    std::deque<MPI::Request> deqNextTaskRequest;
+    // Size of the posted receives: the largest task carries the weights of every link of the
+    // genome, whatever the tasks received before (index-only tasks carry none)
+    size_t unTaskCapacity = 0;
+    {
+        NEAT::Genome* pcStartGenome = NEAT::Genome::new_Genome_load(unGenome.c_str());
+        NEAT::Network* pcStartNetwork = pcStartGenome->genesis(pcStartGenome->genome_id);
+        unTaskCapacity = pagmo::mpi_protocol::task_size(pagmo::mpi_protocol::max_task_runs,
+                                                        pcStartNetwork->getlinks().size());
+        delete pcStartNetwork;
+        delete pcStartGenome;
+    }
+
+    // Batch of the task, then fitness, simulated steps and wall-clock time of each run, sent back
+    // without blocking
+    std::vector<double> vecResult;
+    MPI::Request cResultRequest;
 
     // Load the network
     auto cEntities = cSimulator.GetSpace().GetEntitiesByType("controller");
@@ -91,31 +132,108 @@ int main(int argc, char* argv[]) {
     // Waiting for the parent to give us some work to do.
     while (true) {
 
-        // If we received an end signal, we get out of the while loop.
-        bool cont;
-        parent_comm.Recv(&cont, 1, MPI::BOOL, 0, 1);
+        // Either the oldest posted receive, or a message of unknown size, which is probed first.
+        if (deqNextTaskRequest.empty()) {
+            MPI::Status status;
+            parent_comm.Probe(0, pagmo::mpi_protocol::tag_control, status);
+            vecTask.resize(status.Get_count(MPI::BYTE));
+            parent_comm.Recv(vecTask.data(), vecTask.size(), MPI::BYTE, 0,
+                             pagmo::mpi_protocol::tag_control);
+        } else {
+            deqNextTaskRequest.front().Wait();
+            std::swap(vecTask, deqNextTask.front());
+            deqNextTaskRequest.pop_front();
+            deqNextTask.pop_front();
+        }
+        pagmo::mpi_protocol::task_header sHeader =
+            pagmo::mpi_protocol::unpack_task(vecTask, vecRandomSeed, vecWeights);
+
+        // Cancellation of a task that already ran, or was skipped below
+        if (sHeader.op == pagmo::mpi_protocol::op_cancel) {
+            continue;
+        }
 
-        if (!cont) {
+        // If we received an end signal, we get out of the while loop.
+        if (sHeader.op == pagmo::mpi_protocol::op_end) {
             std::cout << "ID" << id << ": END" << std::endl;
             break;
         }
 
-        MPI::Status status;
-        parent_comm.Probe(0, 1, status);
-        int nNum_runs_per_gen = 0;
-        parent_comm.Recv(&nNum_runs_per_gen, 1, MPI::INT, 0, 1);
-        vecRandomSeed.resize(nNum_runs_per_gen);
+        // New common seed table, broadcast to all the processes
+        if (sHeader.op == pagmo::mpi_protocol::op_seed_table) {
+            int nNum_seeds = 0;
+            parent_comm.Bcast(&nNum_seeds, 1, MPI::INT, 0);
+            vecCommonSeed.resize(nNum_seeds);
+            parent_comm.Bcast(vecCommonSeed.data(), nNum_seeds, MPI::UNSIGNED, 0);
+            continue;
+        }
+
+        // The weights of the candidates are shared by the processes of each node
+        if (sHeader.op == pagmo::mpi_protocol::op_shared_setup) {
+            pcSharedGeneration.reset(new pagmo::mpi_shared_generation(parent_comm, true));
+            continue;
+        }
+
+        // New generation in the shared matrix: its number of candidates and dimension
+        if (sHeader.op == pagmo::mpi_protocol::op_generation) {
+            pcSharedGeneration->publish(nullptr, vecRandomSeed[0], vecRandomSeed[1]);
+            continue;
+        }
+
+        // New search distribution: its dimension, whether the candidates are clamped and whether
+        // it is diagonal
+        if (sHeader.op == pagmo::mpi_protocol::op_sampling_state) {
+            int nDim = vecRandomSeed[0];
+            bool bDiagonal = vecRandomSeed[2] != 0;
+            std::vector<double> vecState(pagmo::packed_sampling_size(nDim, bDiagonal));
+            parent_comm.Bcast(vecState.data(), vecState.size(), MPI::DOUBLE, 0);
+            sSamplingState =
+                pagmo::unpack_sampling_state(vecState, nDim, bDiagonal, vecRandomSeed[1] != 0);
+            continue;
+        }
 
-        // Receiving the weights of the
-        parent_comm.Probe(0, 1, status);
+        // The parent sent indices into the common seed table
+        if (sHeader.op == pagmo::mpi_protocol::op_task_common) {
+            for (auto& seed : vecRandomSeed) {
+                seed = vecCommonSeed.at(seed);
+            }
+        }
 
-        int nNum_weights = status.Get_count(MPI::DOUBLE);
-        double* weights = new double[nNum_weights];
+        // Post the receives of the next messages. They match the messages in the order they are
+        // posted, so they are completed in that order.
+        while (deqNextTaskRequest.size() < size_t(pagmo::mpi_protocol::max_prefetch)) {
+            deqNextTask.emplace_back(unTaskCapacity);
+            deqNextTaskRequest.push_back(
+                parent_comm.Irecv(deqNextTask.back().data(), deqNextTask.back().size(), MPI::BYTE,
+                                  0, pagmo::mpi_protocol::tag_control));
+        }
 
-        parent_comm.Recv(weights, nNum_weights, MPI::DOUBLE, 0, 1);
+        // The task ID is echoed back with the results
+        int nTask = sHeader.task;
 
-        for (int i = 0; i < nNum_runs_per_gen; i++) {
-            vecRandomSeed[i] = pRNG->Uniform(argos::CRange<UInt32>(0, UINT32_MAX));
+        // Skip the task if a cancellation already arrived behind it: another process returned it
+        bool bCancelled = false;
+        for (size_t i = 0; i < deqNextTaskRequest.size() && !bCancelled; i++) {
+            if (!deqNextTaskRequest[i].Test()) {
+                break;
+            }
+            auto sNext = pagmo::mpi_protocol::peek_task(deqNextTask[i]);
+            bCancelled = sNext.op == pagmo::mpi_protocol::op_cancel && sNext.task == nTask;
+        }
+        if (bCancelled) {
+            continue;
+        }
+        int nNum_runs_per_gen = sHeader.n_runs;
+        int nNum_weights = sHeader.n_weights;
+        double* weights = vecWeights.data();
+        if (sHeader.source == pagmo::mpi_protocol::weights_shared) {
+            nNum_weights = pcSharedGeneration->get_dim();
+            weights = pcSharedGeneration->row(sHeader.candidate);
+        } else if (sHeader.source == pagmo::mpi_protocol::weights_sampled) {
+            // Same kernel as the algorithm of the parent: bitwise the same candidate
+            pagmo::sample_candidate(sSamplingState, sHeader.sample_seed, cSampleZ, cSampleX);
+            nNum_weights = cSampleX.size();
+            weights = cSampleX.data();
         }
 
         // Create the new genome, and the network
@@ -138,13 +256,21 @@ int main(int argc, char* argv[]) {
             }
         }
 
-        double dFitness = 0.0;
+        // The previous results must be sent before their buffer is reused
+        cResultRequest.Wait();
+        vecResult.resize(pagmo::mpi_protocol::result_header_size +
+                         nNum_runs_per_gen * pagmo::mpi_protocol::result_run_size);
+        vecResult[0] = sHeader.batch;
+        vecResult[1] = nTask;
         for (int j = 0; j < nNum_runs_per_gen; j++) {
+            auto tStart = std::chrono::steady_clock::now();
+            double dFitness = 0.0;
             try {
 
+                cSimulator.SetRandomSeed(vecRandomSeed[j]);
                 cSimulator.Reset();
                 cSimulator.Execute();
-                dFitness -= cLoopFunctions.GetObjectiveFunction();
+                dFitness = -cLoopFunctions.GetObjectiveFunction();
             } catch (...) {
                 dFitness = 0.0;
                 // cSimulator.Reset();
@@ -153,28 +279,34 @@ int main(int argc, char* argv[]) {
                 std::cout << "length=" << vecRandomSeed.size() << std::endl;
                 std::cout << "seed=" << vecRandomSeed[j] << std::endl;
             }
+            double* pRun = &vecResult[pagmo::mpi_protocol::result_header_size +
+                                      j * pagmo::mpi_protocol::result_run_size];
+            pRun[0] = dFitness;
+            pRun[1] = cSimulator.GetSpace().GetSimulationClock();
+            pRun[2] =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - tStart).count();
         }
 
-        // Compute the average fitness
-        if (nNum_runs_per_gen > 0) {
-            dFitness /= nNum_runs_per_gen;
-        }
-
-        // Send the fitness to the parent.
-        // std::cout << "ID" << id << " --> Average fitness = " << dFitness << std::endl;
-        parent_comm.Send(&dFitness, 1, MPI::DOUBLE, 0, 1);
+        // Send the results of the runs to the parent, which computes the average fitness.
+        cResultRequest =
+            parent_comm.Isend(vecResult.data(), vecResult.size(), MPI::DOUBLE, 0,
+                              pagmo::mpi_protocol::tag_result);
 
         // Removing stuffs
-        delete[] weights;
         // delete genome;
         // delete net;
     }
+    cResultRequest.Wait();
 
-    // Remove category
-    if (CRandom::ExistsCategory("cmaes")) {
-        CRandom::RemoveCategory("cmaes");
+    // Nothing more comes after the end signal
+    for (auto& cRequest : deqNextTaskRequest) {
+        cRequest.Cancel();
+        cRequest.Wait();
     }
 
+    // Collective with the parent and the other processes of the node
+    pcSharedGeneration.reset();
+
     // Dispose of ARGoS stuff
     cSimulator.Destroy();
 